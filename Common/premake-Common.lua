@@ -0,0 +1,41 @@
+
+project "Common"
+  location ""
+  kind "SharedLib"
+  targetdir ("%{wks.location}/build/%{prj.name}-%{cfg.buildcfg}")
+  objdir ("%{wks.location}/build/intermediate/%{prj.name}-%{cfg.buildcfg}")
+  systemversion "latest"
+  language "C++"
+  cppdialect "C++17"
+
+  defines
+  {
+    "COMMON_EXPORTS"
+  }
+    
+  files 
+  {
+    "src/**.h",
+    "src/**.cpp"
+  }
+    
+  includedirs
+  {
+    "src",
+    "%{wks.location}/XornCore/src",
+    "%{wks.location}/DgLib/src"
+  }
+  
+  links
+  {
+    "DgLib",
+	"XornCore"
+  }
+
+  filter "configurations:Debug"
+    runtime "Debug"
+    symbols "on"
+
+  filter "configurations:Release"
+    runtime "Release"
+    optimize "on"
\ No newline at end of file
@@ -0,0 +1,183 @@
+#include <new>
+#include <algorithm>
+
+#include "Arena.h"
+
+namespace Common
+{
+  namespace
+  {
+    // Counts the blocks the arena takes from the heap.
+    class HeapResource : public std::pmr::memory_resource
+    {
+    public:
+
+      HeapResource()
+        : allocations(0)
+        , bytes(0)
+        , reservedBytes(0)
+      {
+
+      }
+
+      uint64_t allocations;
+      uint64_t bytes;
+      uint64_t reservedBytes;
+
+    private:
+
+      void *do_allocate(size_t size, size_t alignment) override
+      {
+        void *p = std::pmr::new_delete_resource()->allocate(size, alignment);
+        allocations++;
+        bytes += size;
+        reservedBytes += size;
+        return p;
+      }
+
+      void do_deallocate(void *p, size_t size, size_t alignment) override
+      {
+        reservedBytes -= size;
+        std::pmr::new_delete_resource()->deallocate(p, size, alignment);
+      }
+
+      bool do_is_equal(std::pmr::memory_resource const &other) const noexcept override
+      {
+        return this == &other;
+      }
+    };
+
+    // Counts what the arena hands out.
+    class CountingResource : public std::pmr::memory_resource
+    {
+    public:
+
+      explicit CountingResource(std::pmr::memory_resource *pUpstream)
+        : pUpstream(pUpstream)
+        , allocations(0)
+        , bytes(0)
+      {
+
+      }
+
+      std::pmr::memory_resource *pUpstream;
+      uint64_t allocations;
+      uint64_t bytes;
+
+    private:
+
+      void *do_allocate(size_t size, size_t alignment) override
+      {
+        allocations++;
+        bytes += size;
+        return pUpstream->allocate(size, alignment);
+      }
+
+      void do_deallocate(void *p, size_t size, size_t alignment) override
+      {
+        pUpstream->deallocate(p, size, alignment);
+      }
+
+      bool do_is_equal(std::pmr::memory_resource const &other) const noexcept override
+      {
+        return this == &other;
+      }
+    };
+  }
+
+  class Arena::PIMPL
+  {
+  public:
+
+    PIMPL(size_t initialSize)
+      : heap()
+      , pBlock(nullptr)
+      , blockSize(std::max<size_t>(initialSize, 1024))
+      , monotonic(nullptr)
+      , counting(nullptr)
+      , peakBytes(0)
+      , resets(0)
+    {
+      pBlock = heap.allocate(blockSize, alignof(std::max_align_t));
+      monotonic = new std::pmr::monotonic_buffer_resource(pBlock, blockSize, &heap);
+      counting.pUpstream = monotonic;
+    }
+
+    ~PIMPL()
+    {
+      delete monotonic;
+      heap.deallocate(pBlock, blockSize, alignof(std::max_align_t));
+    }
+
+    void Reset();
+
+    HeapResource heap;
+    void *pBlock;
+    size_t blockSize;
+    std::pmr::monotonic_buffer_resource *monotonic;
+    CountingResource counting;
+    uint64_t peakBytes;
+    uint64_t resets;
+  };
+
+  void Arena::PIMPL::Reset()
+  {
+    peakBytes = std::max(peakBytes, counting.bytes);
+    monotonic->release();
+
+    // A quarter again covers alignment padding, so the next rebuild of the
+    // same size fits in one block.
+    size_t needed = (size_t)peakBytes + (size_t)peakBytes / 4;
+    if (needed > blockSize)
+    {
+      delete monotonic;
+      heap.deallocate(pBlock, blockSize, alignof(std::max_align_t));
+      blockSize = needed;
+      pBlock = heap.allocate(blockSize, alignof(std::max_align_t));
+      monotonic = new std::pmr::monotonic_buffer_resource(pBlock, blockSize, &heap);
+      counting.pUpstream = monotonic;
+    }
+
+    counting.allocations = 0;
+    counting.bytes = 0;
+    resets++;
+  }
+
+  //----------------------------------------------------------------
+  // Arena
+  //----------------------------------------------------------------
+
+  Arena::Arena(size_t initialSize)
+    : m_pimpl(new PIMPL(initialSize))
+  {
+
+  }
+
+  Arena::~Arena()
+  {
+    delete m_pimpl;
+  }
+
+  void Arena::Reset()
+  {
+    m_pimpl->Reset();
+  }
+
+  std::pmr::memory_resource *Arena::Resource()
+  {
+    return &m_pimpl->counting;
+  }
+
+  ArenaStats Arena::GetStats() const
+  {
+    ArenaStats stats;
+    stats.allocations = m_pimpl->counting.allocations;
+    stats.bytes = m_pimpl->counting.bytes;
+    stats.peakBytes = std::max(m_pimpl->peakBytes, m_pimpl->counting.bytes);
+    stats.heapAllocations = m_pimpl->heap.allocations;
+    stats.heapBytes = m_pimpl->heap.bytes;
+    stats.reservedBytes = m_pimpl->heap.reservedBytes;
+    stats.resets = m_pimpl->resets;
+    return stats;
+  }
+}
\ No newline at end of file
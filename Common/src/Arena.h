@@ -0,0 +1,57 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <memory_resource>
+
+#include "CommonAPI.h"
+
+namespace Common
+{
+  struct ArenaStats
+  {
+    uint64_t allocations;     // Allocations since the last reset
+    uint64_t bytes;           // Bytes requested since the last reset
+    uint64_t peakBytes;       // Most bytes requested between two resets
+    uint64_t heapAllocations; // Blocks taken from the heap, over the arena's life
+    uint64_t heapBytes;       // Bytes of those blocks
+    uint64_t reservedBytes;   // Heap memory the arena holds now
+    uint64_t resets;
+  };
+
+  // Monotonic arena for the temporaries of one rebuild. Allocation bumps a pointer
+  // and deallocation does nothing; Reset frees everything at once. After a reset the
+  // arena holds a single block as large as the biggest rebuild so far, so rebuilds
+  // of a similar size do not touch the heap at all.
+  //
+  // Allocations must not outlive the next Reset. Not thread safe; allocate only
+  // from the thread doing the rebuild.
+  //
+  // The stats only count what goes through this arena. They are not a measure of
+  // a module's heap traffic, most of which bypasses it.
+  class COMMON_API Arena
+  {
+  public:
+
+    explicit Arena(size_t initialSize = 64 * 1024);
+    ~Arena();
+
+    Arena(Arena const &) = delete;
+    Arena &operator=(Arena const &) = delete;
+
+    void Reset();
+
+    // For std::pmr containers, eg std::pmr::vector<int> v(arena.Resource()).
+    std::pmr::memory_resource *Resource();
+
+    ArenaStats GetStats() const;
+
+  private:
+
+    class PIMPL;
+    PIMPL *m_pimpl;
+  };
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,16 @@
+#ifndef COMMONAPI_H
+#define COMMONAPI_H
+
+// Common is built as a shared library so that every plugin in the process uses
+// the same instance of any state it holds.
+#if defined(_WIN32)
+  #ifdef COMMON_EXPORTS
+    #define COMMON_API __declspec(dllexport)
+  #else
+    #define COMMON_API __declspec(dllimport)
+  #endif
+#else
+  #define COMMON_API __attribute__((visibility("default")))
+#endif
+
+#endif
\ No newline at end of file
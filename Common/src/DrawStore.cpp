@@ -0,0 +1,243 @@
+
+#include "DrawStore.h"
+
+namespace Common
+{
+  namespace
+  {
+    enum class BatchType
+    {
+      None,
+      Lines,
+      Circles,
+      Polygons,
+      IndexedPolygons
+    };
+
+    struct Batch
+    {
+      BatchType type;
+      float size;           // Line thickness or circle radius
+      xn::Colour colour;
+      std::vector<xn::seg> segments;
+      std::vector<xn::vec2> centres;
+      std::vector<xn::DgPolygon> polygons;
+      std::vector<PolygonStyle> styles;
+      std::vector<xn::vec2> vertices;
+      std::vector<uint32_t> indices;
+      std::vector<IndexedPolygon> indexed;
+      size_t bytes;
+    };
+  }
+
+  class DrawStore::PIMPL
+  {
+  public:
+
+    PIMPL()
+      : batches()
+      , freeHandles()
+      , scratch()
+      , bytes(0)
+      , uploads(0)
+    {
+
+    }
+
+    // Empties the batch behind the handle, or creates one.
+    Batch &Prepare(DrawHandle *pHandle, BatchType type)
+    {
+      if (*pHandle == InvalidDrawHandle || *pHandle > batches.size() || batches[*pHandle - 1].type == BatchType::None)
+      {
+        if (freeHandles.empty())
+        {
+          batches.push_back(Batch());
+          batches.back().type = BatchType::None;
+          batches.back().bytes = 0;
+          *pHandle = (DrawHandle)batches.size();
+        }
+        else
+        {
+          *pHandle = freeHandles.back();
+          freeHandles.pop_back();
+        }
+      }
+
+      Batch &batch = batches[*pHandle - 1];
+      Empty(&batch);
+      batch.type = type;
+      uploads++;
+      return batch;
+    }
+
+    void Empty(Batch *pBatch)
+    {
+      bytes -= pBatch->bytes;
+      pBatch->bytes = 0;
+      pBatch->segments = std::vector<xn::seg>();
+      pBatch->centres = std::vector<xn::vec2>();
+      pBatch->polygons = std::vector<xn::DgPolygon>();
+      pBatch->styles = std::vector<PolygonStyle>();
+      pBatch->vertices = std::vector<xn::vec2>();
+      pBatch->indices = std::vector<uint32_t>();
+      pBatch->indexed = std::vector<IndexedPolygon>();
+    }
+
+    // Fills the scratch polygon with one polygon of an indexed batch.
+    xn::DgPolygon const &Expand(Batch const &batch, IndexedPolygon const &polygon)
+    {
+      scratch.Clear();
+      for (uint32_t i = polygon.first; i < polygon.first + polygon.count; i++)
+        scratch.PushBack(batch.vertices[batch.indices[i]]);
+      return scratch;
+    }
+
+    Batch const *Find(DrawHandle handle) const
+    {
+      if (handle == InvalidDrawHandle || handle > batches.size() || batches[handle - 1].type == BatchType::None)
+        return nullptr;
+      return &batches[handle - 1];
+    }
+
+    std::vector<Batch> batches;
+    std::vector<DrawHandle> freeHandles;
+    xn::DgPolygon scratch;
+    size_t bytes;
+    uint64_t uploads;
+  };
+
+  DrawStore::DrawStore()
+    : m_pimpl(new PIMPL())
+  {
+
+  }
+
+  DrawStore::~DrawStore()
+  {
+    delete m_pimpl;
+  }
+
+  DrawHandle DrawStore::SetLineGroup(DrawHandle handle, std::vector<xn::seg> segments, float thickness, xn::Colour colour)
+  {
+    Batch &batch = m_pimpl->Prepare(&handle, BatchType::Lines);
+    batch.segments = std::move(segments);
+    batch.size = thickness;
+    batch.colour = colour;
+    batch.bytes = batch.segments.size() * sizeof(xn::seg);
+    m_pimpl->bytes += batch.bytes;
+    return handle;
+  }
+
+  DrawHandle DrawStore::SetCircleGroup(DrawHandle handle, std::vector<xn::vec2> centres, float radius, xn::Colour colour)
+  {
+    Batch &batch = m_pimpl->Prepare(&handle, BatchType::Circles);
+    batch.centres = std::move(centres);
+    batch.size = radius;
+    batch.colour = colour;
+    batch.bytes = batch.centres.size() * sizeof(xn::vec2);
+    m_pimpl->bytes += batch.bytes;
+    return handle;
+  }
+
+  DrawHandle DrawStore::SetPolygons(DrawHandle handle, std::vector<xn::DgPolygon> polygons, std::vector<PolygonStyle> styles)
+  {
+    Batch &batch = m_pimpl->Prepare(&handle, BatchType::Polygons);
+    batch.polygons = std::move(polygons);
+    batch.styles = std::move(styles);
+    batch.styles.resize(batch.polygons.size());
+    batch.bytes = batch.polygons.size() * (sizeof(xn::DgPolygon) + sizeof(PolygonStyle));
+    for (auto const &polygon : batch.polygons)
+      batch.bytes += polygon.Size() * sizeof(xn::vec2);
+    m_pimpl->bytes += batch.bytes;
+    return handle;
+  }
+
+  DrawHandle DrawStore::SetIndexedPolygons(DrawHandle handle, std::vector<xn::vec2> vertices, std::vector<uint32_t> indices,
+                                           std::vector<IndexedPolygon> polygons)
+  {
+    Batch &batch = m_pimpl->Prepare(&handle, BatchType::IndexedPolygons);
+    batch.vertices = std::move(vertices);
+    batch.indices = std::move(indices);
+    batch.indexed = std::move(polygons);
+    batch.bytes = batch.vertices.size() * sizeof(xn::vec2) + batch.indices.size() * sizeof(uint32_t) +
+                  batch.indexed.size() * sizeof(IndexedPolygon);
+    m_pimpl->bytes += batch.bytes;
+    return handle;
+  }
+
+  void DrawStore::Release(DrawHandle handle)
+  {
+    if (m_pimpl->Find(handle) == nullptr)
+      return;
+
+    Batch &batch = m_pimpl->batches[handle - 1];
+    m_pimpl->Empty(&batch);
+    batch.type = BatchType::None;
+    m_pimpl->freeHandles.push_back(handle);
+  }
+
+  void DrawStore::Clear()
+  {
+    m_pimpl->batches.clear();
+    m_pimpl->freeHandles.clear();
+    m_pimpl->bytes = 0;
+  }
+
+  void DrawStore::Draw(DrawHandle handle, xn::IRenderer *pRenderer, uint32_t flags) const
+  {
+    Batch const *pBatch = m_pimpl->Find(handle);
+    if (pBatch == nullptr)
+      return;
+
+    switch (pBatch->type)
+    {
+      case BatchType::Lines:
+        if (!pBatch->segments.empty())
+          pRenderer->DrawLineGroup(pBatch->segments.data(), pBatch->segments.size(), pBatch->size, pBatch->colour, flags);
+        break;
+      case BatchType::Circles:
+        if (!pBatch->centres.empty())
+          pRenderer->DrawFilledCircleGroup(pBatch->centres.data(), pBatch->centres.size(), pBatch->size, pBatch->colour, flags);
+        break;
+      case BatchType::Polygons:
+        for (size_t i = 0; i < pBatch->polygons.size(); i++)
+        {
+          PolygonStyle const &style = pBatch->styles[i];
+          if (style.filled)
+            pRenderer->DrawFilledPolygon(pBatch->polygons[i], style.fill, flags);
+          if (style.thickness > 0.f)
+            pRenderer->DrawPolygon(pBatch->polygons[i], style.thickness, style.outline, flags);
+        }
+        break;
+      case BatchType::IndexedPolygons:
+        for (auto const &polygon : pBatch->indexed)
+        {
+          xn::DgPolygon const &expanded = m_pimpl->Expand(*pBatch, polygon);
+          if (polygon.style.filled)
+            pRenderer->DrawFilledPolygon(expanded, polygon.style.fill, flags);
+          if (polygon.style.thickness > 0.f)
+            pRenderer->DrawPolygon(expanded, polygon.style.thickness, polygon.style.outline, flags);
+        }
+        break;
+      default:
+        break;
+    }
+  }
+
+  size_t DrawStore::GetItemCount(DrawHandle handle) const
+  {
+    Batch const *pBatch = m_pimpl->Find(handle);
+    if (pBatch == nullptr)
+      return 0;
+    return pBatch->segments.size() + pBatch->centres.size() + pBatch->polygons.size() + pBatch->indexed.size();
+  }
+
+  DrawStoreStats DrawStore::GetStats() const
+  {
+    DrawStoreStats stats;
+    stats.batches = m_pimpl->batches.size() - m_pimpl->freeHandles.size();
+    stats.bytes = m_pimpl->bytes;
+    stats.uploads = m_pimpl->uploads;
+    return stats;
+  }
+}
\ No newline at end of file
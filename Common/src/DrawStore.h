@@ -0,0 +1,86 @@
+#ifndef DRAWSTORE_H
+#define DRAWSTORE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+#include "CommonAPI.h"
+#include "xnCommon.h"
+#include "xnGeometry.h"
+#include "xnIRenderer.h"
+
+namespace Common
+{
+  typedef uint32_t DrawHandle;
+
+  DrawHandle const InvalidDrawHandle = 0;
+
+  // How one polygon of a set is drawn. A thickness of 0 draws no outline.
+  struct PolygonStyle
+  {
+    xn::Colour fill;
+    xn::Colour outline;
+    float thickness;
+    bool filled;
+  };
+
+  // A polygon of an indexed set: count indices from first on, into the set's vertices.
+  struct IndexedPolygon
+  {
+    uint32_t first;
+    uint32_t count;
+    PolygonStyle style;
+  };
+
+  struct DrawStoreStats
+  {
+    uint64_t batches;   // Held now
+    uint64_t bytes;     // Held now
+    uint64_t uploads;   // Over the store's life
+  };
+
+  // Draw lists kept in the form the renderer takes, so Render only walks them.
+  // Modules upload a batch when their result changes and draw it by handle every
+  // frame, which still goes through the renderer's immediate-mode calls.
+  //
+  // Indexed polygons share one vertex buffer, as results that share vertices
+  // between polygons hold them. Each is expanded into a reused scratch polygon
+  // as it is drawn, so the store keeps no per-polygon copies.
+  //
+  // Every Set call creates a batch if the handle is InvalidDrawHandle, and replaces
+  // the batch's contents otherwise; pass vectors with std::move to avoid a copy.
+  // Drawing InvalidDrawHandle does nothing. Not thread safe.
+  class COMMON_API DrawStore
+  {
+  public:
+
+    DrawStore();
+    ~DrawStore();
+
+    DrawStore(DrawStore const &) = delete;
+    DrawStore &operator=(DrawStore const &) = delete;
+
+    DrawHandle SetLineGroup(DrawHandle handle, std::vector<xn::seg> segments, float thickness, xn::Colour colour);
+    DrawHandle SetCircleGroup(DrawHandle handle, std::vector<xn::vec2> centres, float radius, xn::Colour colour);
+    DrawHandle SetPolygons(DrawHandle handle, std::vector<xn::DgPolygon> polygons, std::vector<PolygonStyle> styles);
+    DrawHandle SetIndexedPolygons(DrawHandle handle, std::vector<xn::vec2> vertices, std::vector<uint32_t> indices,
+                                  std::vector<IndexedPolygon> polygons);
+
+    // The handle may be reused by the next new batch.
+    void Release(DrawHandle handle);
+    void Clear();
+
+    void Draw(DrawHandle handle, xn::IRenderer *pRenderer, uint32_t flags = 0) const;
+
+    size_t GetItemCount(DrawHandle handle) const;
+    DrawStoreStats GetStats() const;
+
+  private:
+
+    class PIMPL;
+    PIMPL *m_pimpl;
+  };
+}
+
+#endif
\ No newline at end of file
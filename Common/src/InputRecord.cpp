@@ -0,0 +1,478 @@
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "InputRecord.h"
+#include "ResultCache.h"
+#include "Trace.h"
+
+namespace Common
+{
+  static uint32_t const s_version = 1;
+
+  static char const *s_eventNames[] =
+  {
+    "down",
+    "move",
+    "up",
+    "value",
+    "geometry",
+    "frame"
+  };
+
+  //----------------------------------------------------------------
+  // Values
+  //----------------------------------------------------------------
+
+  std::string FormatValue(float value)
+  {
+    char buffer[32] = {};
+    snprintf(buffer, sizeof(buffer), "%.9g", value);
+    return buffer;
+  }
+
+  std::string FormatValue(int value)
+  {
+    return std::to_string(value);
+  }
+
+  std::string FormatValue(bool value)
+  {
+    return value ? "1" : "0";
+  }
+
+  std::string FormatValue(xn::vec2 const &value)
+  {
+    return FormatValue(value.x()) + "," + FormatValue(value.y());
+  }
+
+  std::string FormatValue(std::vector<float> const &values)
+  {
+    std::string result;
+    for (size_t i = 0; i < values.size(); i++)
+    {
+      if (i != 0)
+        result += ",";
+      result += FormatValue(values[i]);
+    }
+    return result;
+  }
+
+  //----------------------------------------------------------------
+  // Writer
+  //----------------------------------------------------------------
+
+  bool WriteInputRecording(char const *path, InputRecording const &recording, std::string *pError)
+  {
+    FILE *pFile = fopen(path, "wb");
+    if (pFile == nullptr)
+    {
+      *pError = std::string("Unable to write '") + path + "'";
+      return false;
+    }
+
+    fprintf(pFile, "xnrec %u\n", s_version);
+    fprintf(pFile, "module %s\n", recording.module.c_str());
+    for (auto const &setting : recording.settings)
+      fprintf(pFile, "setting %s %s\n", setting.first.c_str(), setting.second.c_str());
+
+    for (auto const &loops : recording.geometries)
+    {
+      fprintf(pFile, "geometry %zu\n", loops.size());
+      for (auto const &loop : loops)
+      {
+        fprintf(pFile, "loop %zu", loop.Size());
+        for (auto it = loop.cPointsBegin(); it != loop.cPointsEnd(); it++)
+        {
+          xn::vec2 p = *it;
+          fprintf(pFile, " %.9g %.9g", p.x(), p.y());
+        }
+        fprintf(pFile, "\n");
+      }
+    }
+
+    for (auto const &event : recording.events)
+    {
+      fprintf(pFile, "event %.4f %s", event.ms, s_eventNames[(uint32_t)event.type]);
+      switch (event.type)
+      {
+        case InputEventType::MouseDown:
+        case InputEventType::MouseMove:
+          fprintf(pFile, " %u %.9g %.9g\n", event.modState, event.point.x(), event.point.y());
+          break;
+        case InputEventType::MouseUp:
+          fprintf(pFile, " %u\n", event.modState);
+          break;
+        case InputEventType::Value:
+          fprintf(pFile, " %s %s\n", event.name.c_str(), event.value.c_str());
+          break;
+        case InputEventType::Geometry:
+          fprintf(pFile, " %u\n", event.geometry);
+          break;
+        default:
+          fprintf(pFile, "\n");
+          break;
+      }
+    }
+
+    if (fclose(pFile) != 0)
+    {
+      *pError = std::string("Unable to write '") + path + "'";
+      return false;
+    }
+    return true;
+  }
+
+  //----------------------------------------------------------------
+  // Reader
+  //----------------------------------------------------------------
+
+  static char const *SkipSpaces(char const *p)
+  {
+    while (*p == ' ' || *p == '\t' || *p == '\r')
+      p++;
+    return p;
+  }
+
+  // Reads up to the next space or line end.
+  static char const *ReadToken(char const *p, std::string *pOut)
+  {
+    p = SkipSpaces(p);
+    char const *pBegin = p;
+    while (*p != ' ' && *p != '\t' && *p != '\r' && *p != '\n' && *p != '\0')
+      p++;
+    pOut->assign(pBegin, p);
+    return p;
+  }
+
+  static bool ReadFloat(char const **pp, float *pOut)
+  {
+    char *pEnd = nullptr;
+    *pOut = strtof(*pp, &pEnd);
+    if (pEnd == *pp)
+      return false;
+    *pp = pEnd;
+    return true;
+  }
+
+  static bool ReadUint(char const **pp, uint64_t *pOut)
+  {
+    char *pEnd = nullptr;
+    *pOut = strtoull(*pp, &pEnd, 10);
+    if (pEnd == *pp)
+      return false;
+    *pp = pEnd;
+    return true;
+  }
+
+  static bool ReadPoint(char const **pp, xn::vec2 *pOut)
+  {
+    float x = 0.f;
+    float y = 0.f;
+    if (!ReadFloat(pp, &x) || !ReadFloat(pp, &y))
+      return false;
+    *pOut = xn::vec2(x, y);
+    return true;
+  }
+
+  static bool ReadEvent(char const *p, size_t geometryCount, InputEvent *pEvent)
+  {
+    std::string type;
+    uint64_t value = 0;
+    char *pEnd = nullptr;
+    pEvent->ms = strtod(p, &pEnd);
+    if (pEnd == p)
+      return false;
+    p = pEnd;
+
+    p = ReadToken(p, &type);
+    if (type == "down" || type == "move")
+    {
+      pEvent->type = type == "down" ? InputEventType::MouseDown : InputEventType::MouseMove;
+      if (!ReadUint(&p, &value) || !ReadPoint(&p, &pEvent->point))
+        return false;
+      pEvent->modState = (uint32_t)value;
+      return true;
+    }
+    if (type == "up")
+    {
+      pEvent->type = InputEventType::MouseUp;
+      if (!ReadUint(&p, &value))
+        return false;
+      pEvent->modState = (uint32_t)value;
+      return true;
+    }
+    if (type == "value")
+    {
+      pEvent->type = InputEventType::Value;
+      p = ReadToken(p, &pEvent->name);
+      ReadToken(p, &pEvent->value);
+      return !pEvent->name.empty();
+    }
+    if (type == "geometry")
+    {
+      pEvent->type = InputEventType::Geometry;
+      if (!ReadUint(&p, &value) || value >= geometryCount)
+        return false;
+      pEvent->geometry = (uint32_t)value;
+      return true;
+    }
+    if (type == "frame")
+    {
+      pEvent->type = InputEventType::Frame;
+      return true;
+    }
+    return false;
+  }
+
+  bool ReadInputRecording(char const *path, InputRecording *pRecording, std::string *pError)
+  {
+    *pRecording = InputRecording();
+
+    FILE *pFile = fopen(path, "rb");
+    if (pFile == nullptr)
+    {
+      *pError = std::string("Unable to read '") + path + "'";
+      return false;
+    }
+
+    std::string text;
+    char buffer[64 * 1024];
+    size_t read = 0;
+    while ((read = fread(buffer, 1, sizeof(buffer), pFile)) != 0)
+      text.append(buffer, read);
+    fclose(pFile);
+
+    uint32_t lineNumber = 0;
+    size_t loopsLeft = 0;
+    std::string keyword;
+    char const *p = text.c_str();
+    while (*p != '\0')
+    {
+      lineNumber++;
+      char const *pLineEnd = strchr(p, '\n');
+      if (pLineEnd == nullptr)
+        pLineEnd = p + strlen(p);
+      std::string line(p, pLineEnd);
+      p = *pLineEnd == '\n' ? pLineEnd + 1 : pLineEnd;
+
+      char const *q = ReadToken(line.c_str(), &keyword);
+      bool ok = true;
+      if (keyword.empty())
+        continue;
+
+      if (lineNumber == 1)
+      {
+        uint64_t version = 0;
+        ok = keyword == "xnrec" && ReadUint(&q, &version) && version == s_version;
+      }
+      else if (keyword == "module")
+      {
+        ReadToken(q, &pRecording->module);
+      }
+      else if (keyword == "setting")
+      {
+        std::pair<std::string, std::string> setting;
+        q = ReadToken(q, &setting.first);
+        ReadToken(q, &setting.second);
+        pRecording->settings.push_back(setting);
+      }
+      else if (keyword == "geometry")
+      {
+        uint64_t count = 0;
+        ok = loopsLeft == 0 && ReadUint(&q, &count);
+        loopsLeft = (size_t)count;
+        pRecording->geometries.push_back(std::vector<xn::PolygonLoop>());
+      }
+      else if (keyword == "loop")
+      {
+        uint64_t count = 0;
+        ok = loopsLeft != 0 && ReadUint(&q, &count);
+        xn::PolygonLoop loop;
+        for (uint64_t i = 0; ok && i < count; i++)
+        {
+          xn::vec2 point(0.f, 0.f);
+          ok = ReadPoint(&q, &point);
+          loop.PushBack(point);
+        }
+        if (ok)
+        {
+          pRecording->geometries.back().push_back(loop);
+          loopsLeft--;
+        }
+      }
+      else if (keyword == "event")
+      {
+        InputEvent event = {};
+        ok = loopsLeft == 0 && ReadEvent(q, pRecording->geometries.size(), &event);
+        pRecording->events.push_back(event);
+      }
+      else
+      {
+        ok = false;
+      }
+
+      if (!ok)
+      {
+        *pError = std::string(path) + ":" + std::to_string(lineNumber) + ": bad line";
+        return false;
+      }
+    }
+
+    if (pRecording->module.empty() || pRecording->geometries.empty() || loopsLeft != 0)
+    {
+      *pError = std::string(path) + ": incomplete recording";
+      return false;
+    }
+    return true;
+  }
+
+  //----------------------------------------------------------------
+  // InputRecorder
+  //----------------------------------------------------------------
+
+  class InputRecorder::PIMPL
+  {
+  public:
+
+    PIMPL()
+      : recording()
+      , geometryHashes()
+      , recordingNow(false)
+      , start(0)
+    {
+
+    }
+
+    InputEvent &AddEvent(InputEventType type)
+    {
+      InputEvent event = {};
+      event.ms = (double)(TraceTime() - start) * 1.e-6;
+      event.type = type;
+      recording.events.push_back(event);
+      return recording.events.back();
+    }
+
+    uint32_t AddGeometry(std::vector<xn::PolygonLoop> const &loops)
+    {
+      ContentHash hash;
+      hash.AddLoops(loops);
+      uint64_t value = hash.Value();
+      for (size_t i = 0; i < geometryHashes.size(); i++)
+      {
+        if (geometryHashes[i] == value)
+          return (uint32_t)i;
+      }
+
+      geometryHashes.push_back(value);
+      recording.geometries.push_back(loops);
+      return (uint32_t)(recording.geometries.size() - 1);
+    }
+
+    InputRecording recording;
+    std::vector<uint64_t> geometryHashes;
+    bool recordingNow;
+    uint64_t start;
+  };
+
+  InputRecorder::InputRecorder()
+    : m_pimpl(new PIMPL())
+  {
+
+  }
+
+  InputRecorder::~InputRecorder()
+  {
+    delete m_pimpl;
+  }
+
+  void InputRecorder::Start(char const *module, std::vector<xn::PolygonLoop> const &loops)
+  {
+    m_pimpl->recording = InputRecording();
+    m_pimpl->recording.module = module;
+    m_pimpl->geometryHashes.clear();
+    m_pimpl->AddGeometry(loops);
+    m_pimpl->start = TraceTime();
+    m_pimpl->recordingNow = true;
+  }
+
+  void InputRecorder::Stop()
+  {
+    m_pimpl->recordingNow = false;
+  }
+
+  bool InputRecorder::IsRecording() const
+  {
+    return m_pimpl->recordingNow;
+  }
+
+  void InputRecorder::AddSetting(char const *name, std::string const &value)
+  {
+    if (m_pimpl->recordingNow)
+      m_pimpl->recording.settings.push_back(std::make_pair(std::string(name), value));
+  }
+
+  void InputRecorder::MouseDown(uint32_t modState, xn::vec2 const &point)
+  {
+    if (!m_pimpl->recordingNow)
+      return;
+    InputEvent &event = m_pimpl->AddEvent(InputEventType::MouseDown);
+    event.modState = modState;
+    event.point = point;
+  }
+
+  void InputRecorder::MouseMove(uint32_t modState, xn::vec2 const &point)
+  {
+    if (!m_pimpl->recordingNow)
+      return;
+    InputEvent &event = m_pimpl->AddEvent(InputEventType::MouseMove);
+    event.modState = modState;
+    event.point = point;
+  }
+
+  void InputRecorder::MouseUp(uint32_t modState)
+  {
+    if (!m_pimpl->recordingNow)
+      return;
+    m_pimpl->AddEvent(InputEventType::MouseUp).modState = modState;
+  }
+
+  void InputRecorder::ValueChanged(char const *name, std::string const &value)
+  {
+    if (!m_pimpl->recordingNow)
+      return;
+    InputEvent &event = m_pimpl->AddEvent(InputEventType::Value);
+    event.name = name;
+    event.value = value;
+  }
+
+  void InputRecorder::SetGeometry(std::vector<xn::PolygonLoop> const &loops)
+  {
+    if (!m_pimpl->recordingNow)
+      return;
+    uint32_t geometry = m_pimpl->AddGeometry(loops);
+    m_pimpl->AddEvent(InputEventType::Geometry).geometry = geometry;
+  }
+
+  void InputRecorder::EndFrame()
+  {
+    if (m_pimpl->recordingNow)
+      m_pimpl->AddEvent(InputEventType::Frame);
+  }
+
+  InputRecording const &InputRecorder::GetRecording() const
+  {
+    return m_pimpl->recording;
+  }
+
+  size_t InputRecorder::EventCount() const
+  {
+    return m_pimpl->recording.events.size();
+  }
+
+  bool InputRecorder::Save(char const *path, std::string *pError) const
+  {
+    return WriteInputRecording(path, m_pimpl->recording, pError);
+  }
+}
\ No newline at end of file
@@ -0,0 +1,106 @@
+#ifndef INPUTRECORD_H
+#define INPUTRECORD_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <utility>
+
+#include "CommonAPI.h"
+#include "xnGeometry.h"
+
+namespace Common
+{
+  enum class InputEventType : uint32_t
+  {
+    MouseDown,
+    MouseMove,
+    MouseUp,
+    Value,      // A parameter changed in the UI
+    Geometry,   // SetGeometry was called
+    Frame       // A UI frame ended
+  };
+
+  struct InputEvent
+  {
+    double ms;              // Since the recording started
+    InputEventType type;
+    uint32_t modState;      // Mouse events
+    xn::vec2 point;         // MouseDown and MouseMove
+    uint32_t geometry;      // Geometry: index into InputRecording::geometries
+    std::string name;       // Value
+    std::string value;
+  };
+
+  // Everything needed to drive a module through the same session again. Settings
+  // are the parameter values when recording started; geometry 0 is the geometry
+  // the module held then. Names and values are those of the Runner's name=value
+  // parameters, plus 'simplify' for the simplification tolerance.
+  struct InputRecording
+  {
+    std::string module;
+    std::vector<std::pair<std::string, std::string>> settings;
+    std::vector<std::vector<xn::PolygonLoop>> geometries;
+    std::vector<InputEvent> events;
+  };
+
+  // Text file, one record per line:
+  //
+  //   xnrec 1
+  //   module <name>
+  //   setting <name> <value>
+  //   geometry <loop count>
+  //   loop <vertex count> x y x y ...
+  //   event <ms> down <modState> x y | move <modState> x y | up <modState> |
+  //              value <name> <value> | geometry <index> | frame
+  //
+  // Floats are written with 9 significant digits, so they read back exactly.
+  COMMON_API bool WriteInputRecording(char const *path, InputRecording const &recording, std::string *pError);
+  COMMON_API bool ReadInputRecording(char const *path, InputRecording *pRecording, std::string *pError);
+
+  COMMON_API std::string FormatValue(float value);
+  COMMON_API std::string FormatValue(int value);
+  COMMON_API std::string FormatValue(bool value);
+  COMMON_API std::string FormatValue(xn::vec2 const &value);
+  COMMON_API std::string FormatValue(std::vector<float> const &values);
+
+  // Records the input a module receives. Every call does nothing unless a
+  // recording is running, so modules can call it unconditionally. Geometry that
+  // was seen before is stored once.
+  class COMMON_API InputRecorder
+  {
+  public:
+
+    InputRecorder();
+    ~InputRecorder();
+
+    InputRecorder(InputRecorder const &) = delete;
+    InputRecorder &operator=(InputRecorder const &) = delete;
+
+    // Drops any previous recording. Add the module's current settings next.
+    void Start(char const *module, std::vector<xn::PolygonLoop> const &loops);
+    void Stop();
+    bool IsRecording() const;
+
+    void AddSetting(char const *name, std::string const &value);
+
+    void MouseDown(uint32_t modState, xn::vec2 const &point);
+    void MouseMove(uint32_t modState, xn::vec2 const &point);
+    void MouseUp(uint32_t modState);
+    void ValueChanged(char const *name, std::string const &value);
+    void SetGeometry(std::vector<xn::PolygonLoop> const &loops);
+    void EndFrame();
+
+    // The recording so far, or the last one after Stop.
+    InputRecording const &GetRecording() const;
+    size_t EventCount() const;
+    bool Save(char const *path, std::string *pError) const;
+
+  private:
+
+    class PIMPL;
+    PIMPL *m_pimpl;
+  };
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,250 @@
+
+#include <stdio.h>
+#include <string.h>
+
+#if defined(_WIN32)
+  #include <windows.h>
+#else
+  #include <fcntl.h>
+  #include <unistd.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+#endif
+
+#include "LoopFile.h"
+
+namespace Common
+{
+  static char const s_magic[4] = {'X', 'N', 'L', 'P'};
+
+  class LoopFile::PIMPL
+  {
+  public:
+
+    PIMPL();
+    ~PIMPL();
+
+    bool Map(char const *path);
+    bool Validate();
+    void Unmap();
+
+  public:
+
+    void const *pData;
+    size_t size;
+
+#if defined(_WIN32)
+    HANDLE file;
+    HANDLE mapping;
+#endif
+
+    LoopFileHeader const *pHeader;
+    uint64_t const *pOffsets;
+    float const *pPoints;
+  };
+
+  LoopFile::PIMPL::PIMPL()
+    : pData(nullptr)
+    , size(0)
+#if defined(_WIN32)
+    , file(INVALID_HANDLE_VALUE)
+    , mapping(nullptr)
+#endif
+    , pHeader(nullptr)
+    , pOffsets(nullptr)
+    , pPoints(nullptr)
+  {
+
+  }
+
+  LoopFile::PIMPL::~PIMPL()
+  {
+    Unmap();
+  }
+
+#if defined(_WIN32)
+  bool LoopFile::PIMPL::Map(char const *path)
+  {
+    file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+      return false;
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+      return false;
+    size = (size_t)fileSize.QuadPart;
+
+    mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping == nullptr)
+      return false;
+
+    pData = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    return pData != nullptr;
+  }
+
+  void LoopFile::PIMPL::Unmap()
+  {
+    if (pData != nullptr)
+      UnmapViewOfFile(pData);
+    if (mapping != nullptr)
+      CloseHandle(mapping);
+    if (file != INVALID_HANDLE_VALUE)
+      CloseHandle(file);
+
+    pData = nullptr;
+    size = 0;
+    mapping = nullptr;
+    file = INVALID_HANDLE_VALUE;
+    pHeader = nullptr;
+    pOffsets = nullptr;
+    pPoints = nullptr;
+  }
+#else
+  bool LoopFile::PIMPL::Map(char const *path)
+  {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+      return false;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size == 0)
+    {
+      close(fd);
+      return false;
+    }
+    size = (size_t)info.st_size;
+
+    // The mapping holds its own reference to the file.
+    void *pMapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (pMapped == MAP_FAILED)
+      return false;
+
+    madvise(pMapped, size, MADV_SEQUENTIAL);
+    pData = pMapped;
+    return true;
+  }
+
+  void LoopFile::PIMPL::Unmap()
+  {
+    if (pData != nullptr)
+      munmap(const_cast<void *>(pData), size);
+
+    pData = nullptr;
+    size = 0;
+    pHeader = nullptr;
+    pOffsets = nullptr;
+    pPoints = nullptr;
+  }
+#endif
+
+  bool LoopFile::PIMPL::Validate()
+  {
+    if (size < sizeof(LoopFileHeader))
+      return false;
+
+    LoopFileHeader const *pHead = static_cast<LoopFileHeader const *>(pData);
+    if (memcmp(pHead->magic, s_magic, sizeof(s_magic)) != 0 || pHead->version != LoopFileVersion)
+      return false;
+
+    // Check the sizes before multiplying them out, so a corrupt header cannot overflow.
+    uint64_t available = size - sizeof(LoopFileHeader);
+    if (pHead->loopCount >= available / sizeof(uint64_t) || pHead->vertexCount > available / (2 * sizeof(float)))
+      return false;
+
+    uint64_t offsetBytes = (pHead->loopCount + 1) * sizeof(uint64_t);
+    uint64_t pointBytes = pHead->vertexCount * 2 * sizeof(float);
+    if (offsetBytes + pointBytes != available)
+      return false;
+
+    uint64_t const *pOffs = reinterpret_cast<uint64_t const *>(pHead + 1);
+    if (pOffs[0] != 0 || pOffs[pHead->loopCount] != pHead->vertexCount)
+      return false;
+    for (uint64_t i = 0; i < pHead->loopCount; i++)
+    {
+      if (pOffs[i + 1] < pOffs[i])
+        return false;
+    }
+
+    pHeader = pHead;
+    pOffsets = pOffs;
+    pPoints = reinterpret_cast<float const *>(pOffs + pHead->loopCount + 1);
+    return true;
+  }
+
+  //----------------------------------------------------------------
+  // LoopFile
+  //----------------------------------------------------------------
+
+  LoopFile::LoopFile()
+    : m_pimpl(new PIMPL())
+  {
+
+  }
+
+  LoopFile::~LoopFile()
+  {
+    delete m_pimpl;
+  }
+
+  bool LoopFile::Open(char const *path)
+  {
+    Close();
+    if (!m_pimpl->Map(path) || !m_pimpl->Validate())
+    {
+      Close();
+      return false;
+    }
+    return true;
+  }
+
+  void LoopFile::Close()
+  {
+    m_pimpl->Unmap();
+  }
+
+  size_t LoopFile::LoopCount() const
+  {
+    return m_pimpl->pHeader == nullptr ? 0 : (size_t)m_pimpl->pHeader->loopCount;
+  }
+
+  size_t LoopFile::VertexCount() const
+  {
+    return m_pimpl->pHeader == nullptr ? 0 : (size_t)m_pimpl->pHeader->vertexCount;
+  }
+
+  float const *LoopFile::LoopPoints(size_t loop) const
+  {
+    return m_pimpl->pPoints + m_pimpl->pOffsets[loop] * 2;
+  }
+
+  size_t LoopFile::LoopSize(size_t loop) const
+  {
+    return (size_t)(m_pimpl->pOffsets[loop + 1] - m_pimpl->pOffsets[loop]);
+  }
+
+  //----------------------------------------------------------------
+  // Writer
+  //----------------------------------------------------------------
+
+  bool WriteLoopFile(char const *path, float const *pPoints, uint64_t const *pOffsets, size_t loopCount)
+  {
+    FILE *pFile = fopen(path, "wb");
+    if (pFile == nullptr)
+      return false;
+
+    LoopFileHeader header;
+    memcpy(header.magic, s_magic, sizeof(s_magic));
+    header.version = LoopFileVersion;
+    header.loopCount = loopCount;
+    header.vertexCount = pOffsets[loopCount];
+
+    bool ok = fwrite(&header, sizeof(header), 1, pFile) == 1;
+    ok = ok && fwrite(pOffsets, sizeof(uint64_t), loopCount + 1, pFile) == loopCount + 1;
+    if (header.vertexCount != 0)
+      ok = ok && fwrite(pPoints, sizeof(float) * 2, (size_t)header.vertexCount, pFile) == header.vertexCount;
+
+    ok = fclose(pFile) == 0 && ok;
+    return ok;
+  }
+}
\ No newline at end of file
@@ -0,0 +1,62 @@
+#ifndef LOOPFILE_H
+#define LOOPFILE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "CommonAPI.h"
+
+namespace Common
+{
+  // Binary loop file, little endian:
+  //
+  //   LoopFileHeader
+  //   uint64_t offsets[loopCount + 1]  Loop i is vertices [offsets[i], offsets[i + 1])
+  //   float    points[vertexCount * 2] Packed x, y pairs
+  //
+  // Every section starts on an 8 byte boundary, so the file can be used in place.
+  struct LoopFileHeader
+  {
+    char magic[4];        // 'XNLP'
+    uint32_t version;
+    uint64_t loopCount;
+    uint64_t vertexCount;
+  };
+
+  uint32_t const LoopFileVersion = 1;
+
+  // Read-only, memory-mapped view of a loop file. Loop data points straight into
+  // the mapping and stays valid until the file is closed.
+  class COMMON_API LoopFile
+  {
+  public:
+
+    LoopFile();
+    ~LoopFile();
+
+    LoopFile(LoopFile const &) = delete;
+    LoopFile &operator=(LoopFile const &) = delete;
+
+    // Fails if the file cannot be mapped or is not a valid loop file.
+    bool Open(char const *path);
+    void Close();
+
+    size_t LoopCount() const;
+    size_t VertexCount() const;
+
+    // x, y pairs of one loop.
+    float const *LoopPoints(size_t loop) const;
+    size_t LoopSize(size_t loop) const;
+
+  private:
+
+    class PIMPL;
+    PIMPL *m_pimpl;
+  };
+
+  // pPoints holds offsets[loopCount] x, y pairs. pOffsets holds loopCount + 1
+  // ascending vertex offsets, starting at 0.
+  COMMON_API bool WriteLoopFile(char const *path, float const *pPoints, uint64_t const *pOffsets, size_t loopCount);
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,67 @@
+#include "ModulePanel.h"
+#include "ResultCache.h"
+
+namespace Common
+{
+  namespace
+  {
+    std::string Label(char const *text, ModulePanel const &panel)
+    {
+      return std::string(text) + "##" + panel.module;
+    }
+  }
+
+  bool DoPanelHeader(xn::UIContext *pContext, ModulePanel const &panel, std::string *pError)
+  {
+    panel.pFrameTimes->EndFrame();
+    panel.pRecorder->EndFrame();
+
+    bool success = true;
+    FrameTimes const &frameTimes = *panel.pFrameTimes;
+    pContext->Text("Frame: %.3f ms (avg %.3f ms, max %.3f ms)", frameTimes.LastMs(), frameTimes.AverageMs(), frameTimes.MaxMs());
+    bool tracing = IsTracing();
+    if (pContext->Checkbox(Label("Record trace", panel).c_str(), &tracing))
+      SetTracing(tracing);
+    if (pContext->Button(Label("Export trace", panel).c_str()) && !WriteChromeTrace("trace.json"))
+    {
+      *pError = "Failed to write trace.json";
+      success = false;
+    }
+
+    bool recording = panel.pRecorder->IsRecording();
+    if (pContext->Checkbox(Label("Record input", panel).c_str(), &recording))
+    {
+      if (recording)
+        panel.startRecording();
+      else
+        panel.pRecorder->Stop();
+    }
+    if (pContext->Button(Label("Save input", panel).c_str()) && !panel.pRecorder->Save("input.xnr", pError))
+      success = false;
+
+    ArenaStats arenaStats = panel.pArena->GetStats();
+    pContext->Text("Arena only: %u allocations, %.1f KB (peak %.1f KB), %u blocks", (uint32_t)arenaStats.allocations, (float)arenaStats.bytes / 1024.f, (float)arenaStats.peakBytes / 1024.f, (uint32_t)arenaStats.heapAllocations);
+    if (panel.cacheCategory != nullptr)
+    {
+      CacheStats cacheStats = ResultCache::Shared().GetStats(panel.cacheCategory);
+      pContext->Text("Cache: %u hits, %u misses, %.1f KB held", (uint32_t)cacheStats.hits, (uint32_t)cacheStats.misses, (float)cacheStats.bytes / 1024.f);
+    }
+    return success;
+  }
+
+  void DoSimplifyControls(xn::UIContext *pContext, ModulePanel const &panel)
+  {
+    Simplifier &simplifier = *panel.pSimplifier;
+    float tolerance = simplifier.GetTolerance();
+    if (pContext->InputFloat(Label("Simplify tolerance", panel).c_str(), &tolerance, 0.1f, 1.f))
+    {
+      simplifier.SetTolerance(tolerance);
+      panel.pRecorder->ValueChanged("simplify", FormatValue(tolerance));
+      panel.resimplify();
+    }
+
+    SimplifyStats const &stats = simplifier.GetStats();
+    float ratio = stats.inputVertices == 0 ? 1.f : (float)stats.outputVertices / (float)stats.inputVertices;
+    pContext->Text("Simplified: %u -> %u vertices (%.1f%%), %.3f ms", (uint32_t)stats.inputVertices, (uint32_t)stats.outputVertices, ratio * 100.f, stats.ms);
+  }
+}
\ No newline at end of file
@@ -0,0 +1,42 @@
+#ifndef MODULEPANEL_H
+#define MODULEPANEL_H
+
+#include <string>
+#include <functional>
+
+#include "CommonAPI.h"
+#include "xnModule.h"
+
+#include "Arena.h"
+#include "InputRecord.h"
+#include "Simplify.h"
+#include "Trace.h"
+
+namespace Common
+{
+  // The parts of a module that every module panel shows. The module name is also
+  // the label suffix, so the controls of different modules stay apart.
+  struct ModulePanel
+  {
+    char const *module;
+    FrameTimes *pFrameTimes;
+    Simplifier *pSimplifier;
+    Arena const *pArena;
+    InputRecorder *pRecorder;
+    char const *cacheCategory;            // Null if the module caches nothing
+    std::function<void()> startRecording; // Starts pRecorder with the module's settings
+    std::function<void()> resimplify;     // Redoes SetGeometry on the simplifier's input
+  };
+
+  // Closes the frame of the frame times and the recorder, then shows the frame
+  // time, the trace and input recording controls, and the arena and cache stats.
+  // Call once per frame, from _DoFrame. Returns false, with pError set, if
+  // exporting the trace or saving the input failed.
+  COMMON_API bool DoPanelHeader(xn::UIContext *pContext, ModulePanel const &panel, std::string *pError);
+
+  // Shows the simplify tolerance and what the last simplification did. A changed
+  // tolerance is recorded and applied through resimplify before the stats are shown.
+  COMMON_API void DoSimplifyControls(xn::UIContext *pContext, ModulePanel const &panel);
+}
+
+#endif
\ No newline at end of file
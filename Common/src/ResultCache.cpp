@@ -0,0 +1,343 @@
+
+#include <list>
+#include <mutex>
+#include <string>
+#include <cstring>
+#include <unordered_map>
+
+#include "ResultCache.h"
+#include "Trace.h"
+
+namespace Common
+{
+  static uint64_t const s_prime1 = 0x9E3779B97F4A7C15ull;
+  static uint64_t const s_prime2 = 0xC2B2AE3D27D4EB4Full;
+
+  static inline uint64_t Rotate(uint64_t x, int bits)
+  {
+    return (x << bits) | (x >> (64 - bits));
+  }
+
+  //----------------------------------------------------------------
+  // ContentHash
+  //----------------------------------------------------------------
+
+  ContentHash::ContentHash(uint64_t seed)
+    : m_state(seed + s_prime2)
+    , m_words(0)
+  {
+
+  }
+
+  void ContentHash::Mix(uint64_t word)
+  {
+    m_state ^= Rotate(word * s_prime2, 31) * s_prime1;
+    m_state = Rotate(m_state, 27) * s_prime1 + s_prime2;
+    m_words++;
+  }
+
+  void ContentHash::AddBytes(void const *pData, size_t size)
+  {
+    unsigned char const *pBytes = static_cast<unsigned char const *>(pData);
+    size_t words = size / 8;
+    for (size_t i = 0; i < words; i++)
+    {
+      uint64_t word;
+      memcpy(&word, pBytes + i * 8, 8);
+      Mix(word);
+    }
+
+    // The tail goes in one word, with its length, so 'ab' + 'c' and 'a' + 'bc' differ.
+    uint64_t tail = (uint64_t)(size % 8) << 56;
+    memcpy(&tail, pBytes + words * 8, size % 8);
+    Mix(tail);
+  }
+
+  void ContentHash::AddLoop(xn::PolygonLoop const &loop)
+  {
+    Mix((uint64_t)loop.Size());
+    for (auto it = loop.cPointsBegin(); it != loop.cPointsEnd(); it++)
+    {
+      xn::vec2 p = *it;
+      uint32_t bits[2];
+      float coords[2] = {p.x(), p.y()};
+      memcpy(bits, coords, sizeof(bits));
+      Mix((uint64_t)bits[0] | ((uint64_t)bits[1] << 32));
+    }
+  }
+
+  void ContentHash::AddLoops(std::vector<xn::PolygonLoop> const &loops)
+  {
+    Mix((uint64_t)loops.size());
+    for (auto const &loop : loops)
+      AddLoop(loop);
+  }
+
+  uint64_t ContentHash::Value() const
+  {
+    uint64_t h = m_state ^ m_words;
+    h ^= h >> 33;
+    h *= 0xFF51AFD7ED558CCDull;
+    h ^= h >> 33;
+    h *= 0xC4CEB9FE1A85EC53ull;
+    h ^= h >> 33;
+    return h;
+  }
+
+  uint64_t HashLoop(xn::PolygonLoop const &loop)
+  {
+    ContentHash hash;
+    hash.AddLoop(loop);
+    return hash.Value();
+  }
+
+  //----------------------------------------------------------------
+  // ResultCache::PIMPL
+  //----------------------------------------------------------------
+
+  class ResultCache::PIMPL
+  {
+    struct Entry
+    {
+      std::string category;
+      uint64_t key;
+      CachedResult data;
+    };
+
+    typedef std::list<Entry>::iterator EntryIt;
+
+  public:
+
+    explicit PIMPL(size_t byteLimit);
+
+    void SetByteLimit(size_t byteLimit);
+    CachedResult Find(char const *category, uint64_t key);
+    void Insert(char const *category, uint64_t key, std::vector<uint8_t> &&data);
+    void Clear();
+
+    void GetStats(std::vector<CacheStats> *pStats) const;
+    CacheStats GetStats(char const *category) const;
+    void ResetStats();
+
+  public:
+
+    size_t byteLimit;
+
+  private:
+
+    static uint64_t IndexKey(char const *category, uint64_t key);
+    CacheStats &GetCategoryStats(char const *category);
+    void Remove(EntryIt it);
+    void Trim();
+
+    mutable std::mutex m_mutex;
+    std::list<Entry> m_entries; // Most recently used first
+    std::unordered_map<uint64_t, EntryIt> m_index;
+    std::vector<CacheStats> m_stats;
+    size_t m_bytes;
+  };
+
+  ResultCache::PIMPL::PIMPL(size_t byteLimit)
+    : byteLimit(byteLimit)
+    , m_mutex()
+    , m_entries()
+    , m_index()
+    , m_stats()
+    , m_bytes(0)
+  {
+
+  }
+
+  uint64_t ResultCache::PIMPL::IndexKey(char const *category, uint64_t key)
+  {
+    ContentHash hash(key);
+    hash.AddBytes(category, strlen(category));
+    return hash.Value();
+  }
+
+  CacheStats &ResultCache::PIMPL::GetCategoryStats(char const *category)
+  {
+    for (auto &stats : m_stats)
+    {
+      if (stats.category == category)
+        return stats;
+    }
+    m_stats.push_back(CacheStats{category, 0, 0, 0, 0, 0, 0});
+    return m_stats.back();
+  }
+
+  void ResultCache::PIMPL::Remove(EntryIt it)
+  {
+    CacheStats &stats = GetCategoryStats(it->category.c_str());
+    stats.entries--;
+    stats.bytes -= it->data->size();
+    m_bytes -= it->data->size();
+    m_index.erase(IndexKey(it->category.c_str(), it->key));
+    m_entries.erase(it);
+  }
+
+  void ResultCache::PIMPL::Trim()
+  {
+    while (m_bytes > byteLimit && !m_entries.empty())
+    {
+      EntryIt oldest = std::prev(m_entries.end());
+      GetCategoryStats(oldest->category.c_str()).evictions++;
+      Remove(oldest);
+    }
+  }
+
+  void ResultCache::PIMPL::SetByteLimit(size_t limit)
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    byteLimit = limit;
+    Trim();
+  }
+
+  CachedResult ResultCache::PIMPL::Find(char const *category, uint64_t key)
+  {
+    XN_TRACE_SCOPE(category, "CacheFind");
+    std::lock_guard<std::mutex> lock(m_mutex);
+    CacheStats &stats = GetCategoryStats(category);
+
+    auto found = m_index.find(IndexKey(category, key));
+    if (found == m_index.end() || found->second->key != key || found->second->category != category)
+    {
+      stats.misses++;
+      return nullptr;
+    }
+
+    stats.hits++;
+    m_entries.splice(m_entries.begin(), m_entries, found->second);
+    return found->second->data;
+  }
+
+  void ResultCache::PIMPL::Insert(char const *category, uint64_t key, std::vector<uint8_t> &&data)
+  {
+    XN_TRACE_SCOPE(category, "CacheInsert");
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto found = m_index.find(IndexKey(category, key));
+    if (found != m_index.end())
+      Remove(found->second);
+
+    if (data.size() > byteLimit)
+      return;
+
+    size_t size = data.size();
+    m_entries.push_front(Entry{category, key, std::make_shared<std::vector<uint8_t> const>(std::move(data))});
+    m_index[IndexKey(category, key)] = m_entries.begin();
+    m_bytes += size;
+
+    CacheStats &stats = GetCategoryStats(category);
+    stats.insertions++;
+    stats.entries++;
+    stats.bytes += size;
+    Trim();
+  }
+
+  void ResultCache::PIMPL::Clear()
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_entries.clear();
+    m_index.clear();
+    m_bytes = 0;
+    for (auto &stats : m_stats)
+    {
+      stats.entries = 0;
+      stats.bytes = 0;
+    }
+  }
+
+  void ResultCache::PIMPL::GetStats(std::vector<CacheStats> *pStats) const
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    *pStats = m_stats;
+  }
+
+  CacheStats ResultCache::PIMPL::GetStats(char const *category) const
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto const &stats : m_stats)
+    {
+      if (stats.category == category)
+        return stats;
+    }
+    return CacheStats{category, 0, 0, 0, 0, 0, 0};
+  }
+
+  void ResultCache::PIMPL::ResetStats()
+  {
+    // Entries and bytes describe what is held, so they are kept.
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto &stats : m_stats)
+    {
+      stats.hits = 0;
+      stats.misses = 0;
+      stats.insertions = 0;
+      stats.evictions = 0;
+    }
+  }
+
+  //----------------------------------------------------------------
+  // ResultCache
+  //----------------------------------------------------------------
+
+  ResultCache::ResultCache(size_t byteLimit)
+    : m_pimpl(new PIMPL(byteLimit))
+  {
+
+  }
+
+  ResultCache::~ResultCache()
+  {
+    delete m_pimpl;
+  }
+
+  ResultCache &ResultCache::Shared()
+  {
+    // Never destroyed, like the shared thread pool, so modules unloading late can
+    // still release the results they hold.
+    static ResultCache *s_pCache = new ResultCache();
+    return *s_pCache;
+  }
+
+  void ResultCache::SetByteLimit(size_t byteLimit)
+  {
+    m_pimpl->SetByteLimit(byteLimit);
+  }
+
+  size_t ResultCache::GetByteLimit() const
+  {
+    return m_pimpl->byteLimit;
+  }
+
+  CachedResult ResultCache::Find(char const *category, uint64_t key)
+  {
+    return m_pimpl->Find(category, key);
+  }
+
+  void ResultCache::Insert(char const *category, uint64_t key, std::vector<uint8_t> &&data)
+  {
+    m_pimpl->Insert(category, key, std::move(data));
+  }
+
+  void ResultCache::Clear()
+  {
+    m_pimpl->Clear();
+  }
+
+  void ResultCache::GetStats(std::vector<CacheStats> *pStats) const
+  {
+    m_pimpl->GetStats(pStats);
+  }
+
+  CacheStats ResultCache::GetStats(char const *category) const
+  {
+    return m_pimpl->GetStats(category);
+  }
+
+  void ResultCache::ResetStats()
+  {
+    m_pimpl->ResetStats();
+  }
+}
\ No newline at end of file
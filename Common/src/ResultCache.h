@@ -0,0 +1,259 @@
+#ifndef RESULTCACHE_H
+#define RESULTCACHE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <memory>
+#include <string>
+#include <vector>
+#include <type_traits>
+
+#include "CommonAPI.h"
+#include "xnCommon.h"
+#include "xnGeometry.h"
+
+namespace Common
+{
+  // 64 bit content hash, built up from a sequence of Add calls. Data is mixed eight
+  // bytes at a time, so hashing loop data costs about as much as reading it. The
+  // same sequence of calls gives the same value; values are not stable across builds.
+  class COMMON_API ContentHash
+  {
+  public:
+
+    explicit ContentHash(uint64_t seed = 0);
+
+    void AddBytes(void const *pData, size_t size);
+    void AddLoop(xn::PolygonLoop const &loop);
+    void AddLoops(std::vector<xn::PolygonLoop> const &loops);
+
+    template<typename T>
+    void Add(T const &value)
+    {
+      static_assert(std::is_trivially_copyable<T>::value, "Only plain values can be hashed");
+      AddBytes(&value, sizeof(T));
+    }
+
+    uint64_t Value() const;
+
+  private:
+
+    void Mix(uint64_t word);
+
+    uint64_t m_state;
+    uint64_t m_words;
+  };
+
+  COMMON_API uint64_t HashLoop(xn::PolygonLoop const &loop);
+
+  // Appends plain values and arrays of them to a byte buffer, for storing a
+  // module result in the cache.
+  class ResultWriter
+  {
+  public:
+
+    void WriteBytes(void const *pData, size_t size)
+    {
+      unsigned char const *pBytes = static_cast<unsigned char const *>(pData);
+      m_data.insert(m_data.end(), pBytes, pBytes + size);
+    }
+
+    template<typename T>
+    void Write(T const &value)
+    {
+      static_assert(std::is_trivially_copyable<T>::value, "Only plain values can be written");
+      WriteBytes(&value, sizeof(T));
+    }
+
+    // The element count, followed by the elements.
+    template<typename T>
+    void WriteArray(std::vector<T> const &values)
+    {
+      static_assert(std::is_trivially_copyable<T>::value, "Only plain values can be written");
+      Write<uint64_t>(values.size());
+      WriteBytes(values.data(), values.size() * sizeof(T));
+    }
+
+    // Geometry types are written coordinate by coordinate, as they need not be
+    // trivially copyable.
+    void WritePoint(xn::vec2 const &p)
+    {
+      float coords[2] = {p.x(), p.y()};
+      WriteBytes(coords, sizeof(coords));
+    }
+
+    void WritePoints(std::vector<xn::vec2> const &points)
+    {
+      Write<uint64_t>(points.size());
+      for (auto const &p : points)
+        WritePoint(p);
+    }
+
+    void WriteSegments(std::vector<xn::seg> const &segments)
+    {
+      Write<uint64_t>(segments.size());
+      for (auto const &s : segments)
+      {
+        WritePoint(s.GetP0());
+        WritePoint(s.GetP1());
+      }
+    }
+
+    std::vector<uint8_t> &Data() { return m_data; }
+
+  private:
+
+    std::vector<uint8_t> m_data;
+  };
+
+  // Reads back what a ResultWriter wrote. Every read fails, and leaves the output
+  // untouched, if it would run past the end of the data.
+  class ResultReader
+  {
+  public:
+
+    explicit ResultReader(std::vector<uint8_t> const &data)
+      : m_pData(data.data())
+      , m_size(data.size())
+      , m_offset(0)
+    {
+
+    }
+
+    bool ReadBytes(void *pOut, size_t size)
+    {
+      if (size > m_size - m_offset)
+        return false;
+      if (size != 0)
+        memcpy(pOut, m_pData + m_offset, size);
+      m_offset += size;
+      return true;
+    }
+
+    template<typename T>
+    bool Read(T *pValue)
+    {
+      static_assert(std::is_trivially_copyable<T>::value, "Only plain values can be read");
+      return ReadBytes(pValue, sizeof(T));
+    }
+
+    template<typename T>
+    bool ReadArray(std::vector<T> *pValues)
+    {
+      static_assert(std::is_trivially_copyable<T>::value, "Only plain values can be read");
+      uint64_t count = 0;
+      if (!Read(&count) || count > (m_size - m_offset) / sizeof(T))
+        return false;
+      pValues->resize((size_t)count);
+      return ReadBytes(pValues->data(), (size_t)count * sizeof(T));
+    }
+
+    bool ReadPoint(xn::vec2 *pPoint)
+    {
+      float coords[2];
+      if (!ReadBytes(coords, sizeof(coords)))
+        return false;
+      *pPoint = xn::vec2(coords[0], coords[1]);
+      return true;
+    }
+
+    bool ReadPoints(std::vector<xn::vec2> *pPoints)
+    {
+      uint64_t count = 0;
+      if (!Read(&count) || count > (m_size - m_offset) / (2 * sizeof(float)))
+        return false;
+      pPoints->resize((size_t)count);
+      for (auto &p : *pPoints)
+        ReadPoint(&p);
+      return true;
+    }
+
+    bool ReadSegments(std::vector<xn::seg> *pSegments)
+    {
+      uint64_t count = 0;
+      if (!Read(&count) || count > (m_size - m_offset) / (4 * sizeof(float)))
+        return false;
+      pSegments->clear();
+      pSegments->reserve((size_t)count);
+      for (uint64_t i = 0; i < count; i++)
+      {
+        xn::vec2 p0(0.f, 0.f), p1(0.f, 0.f);
+        ReadPoint(&p0);
+        ReadPoint(&p1);
+        pSegments->push_back(xn::seg(p0, p1));
+      }
+      return true;
+    }
+
+    bool AtEnd() const { return m_offset == m_size; }
+
+  private:
+
+    uint8_t const *m_pData;
+    size_t m_size;
+    size_t m_offset;
+  };
+
+  // Totals for the results stored under one category.
+  struct CacheStats
+  {
+    std::string category;
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t insertions;
+    uint64_t evictions;
+    uint64_t entries;   // Held now
+    uint64_t bytes;     // Held now
+  };
+
+  typedef std::shared_ptr<std::vector<uint8_t> const> CachedResult;
+
+  // Serialized module results, keyed on a content hash of the input and the
+  // parameters that produced them. When the held bytes go over the limit, the least
+  // recently used results are dropped. Thread safe.
+  //
+  // Modules should use Shared(), so one limit covers the whole process and a
+  // module that is switched away from and back to finds its results still there.
+  class COMMON_API ResultCache
+  {
+  public:
+
+    static size_t const DefaultByteLimit = 256 * 1024 * 1024;
+
+    explicit ResultCache(size_t byteLimit = DefaultByteLimit);
+    ~ResultCache();
+
+    ResultCache(ResultCache const &) = delete;
+    ResultCache &operator=(ResultCache const &) = delete;
+
+    static ResultCache &Shared();
+
+    // A limit of 0 turns the cache off.
+    void SetByteLimit(size_t byteLimit);
+    size_t GetByteLimit() const;
+
+    // The category keeps the results of different modules apart and labels them in
+    // the statistics. It is copied, so it need not outlive the call. Returns null on a miss. The result stays
+    // valid while it is held, even if it is evicted in the meantime.
+    CachedResult Find(char const *category, uint64_t key);
+
+    // Replaces any result held under the same key. Results larger than the limit
+    // are not stored.
+    void Insert(char const *category, uint64_t key, std::vector<uint8_t> &&data);
+
+    void Clear();
+
+    // Totals per category since the last reset.
+    void GetStats(std::vector<CacheStats> *pStats) const;
+    CacheStats GetStats(char const *category) const;
+    void ResetStats();
+
+  private:
+
+    class PIMPL;
+    PIMPL *m_pimpl;
+  };
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,324 @@
+
+#include <set>
+#include <cmath>
+#include <cfloat>
+#include <limits>
+#include <algorithm>
+
+#include "SegmentSweep.h"
+#include "Trace.h"
+
+namespace Common
+{
+  namespace
+  {
+    bool PointLess(SweepPoint const &a, SweepPoint const &b)
+    {
+      return a.x < b.x || (a.x == b.x && a.y < b.y);
+    }
+
+    struct PointCompare
+    {
+      bool operator()(SweepPoint const &a, SweepPoint const &b) const { return PointLess(a, b); }
+    };
+
+    double Cross(double ax, double ay, double bx, double by)
+    {
+      return ax * by - ay * bx;
+    }
+
+    class Sweep
+    {
+      // Orders the status structure by height at the sweep point. Segments that
+      // meet at the sweep point are ordered by slope, ie by height just after it.
+      struct StatusCompare
+      {
+        typedef void is_transparent;
+
+        Sweep const *pSweep;
+
+        bool operator()(uint32_t a, uint32_t b) const { return pSweep->Below(a, b); }
+        bool operator()(uint32_t a, double y) const { return pSweep->HeightAt(a) < y; }
+        bool operator()(double y, uint32_t a) const { return y < pSweep->HeightAt(a); }
+      };
+
+      typedef std::set<uint32_t, StatusCompare> Status;
+
+      struct Segment
+      {
+        SweepPoint p0; // Lexicographically smallest end point
+        SweepPoint p1;
+        double slope;
+      };
+
+    public:
+
+      Sweep(std::vector<SweepSegment> const &segments);
+      void Run(SweepCallback const &callback);
+
+    private:
+
+      double HeightAt(uint32_t id) const;
+      bool Below(uint32_t a, uint32_t b) const;
+      bool Near(SweepPoint const &a, SweepPoint const &b) const;
+      void Check(uint32_t a, uint32_t b);
+
+    private:
+
+      std::vector<Segment> m_segments;
+      std::vector<uint32_t> m_starts;
+      std::set<SweepPoint, PointCompare> m_events;
+      Status m_status;
+      SweepPoint m_point;
+      double m_epsilon;
+    };
+
+    Sweep::Sweep(std::vector<SweepSegment> const &segments)
+      : m_segments()
+      , m_starts()
+      , m_events()
+      , m_status(StatusCompare{this})
+      , m_point{0.0, 0.0}
+      , m_epsilon(0.0)
+    {
+      double extent = 0.0;
+      for (uint32_t i = 0; i < (uint32_t)segments.size(); i++)
+      {
+        Segment s;
+        s.p0 = segments[i].p0;
+        s.p1 = segments[i].p1;
+        if (PointLess(s.p1, s.p0))
+          std::swap(s.p0, s.p1);
+
+        double dx = s.p1.x - s.p0.x;
+        s.slope = dx == 0.0 ? std::numeric_limits<double>::infinity() : (s.p1.y - s.p0.y) / dx;
+        m_segments.push_back(s);
+
+        extent = std::max(extent, std::max(std::fabs(s.p0.x), std::fabs(s.p0.y)));
+        extent = std::max(extent, std::max(std::fabs(s.p1.x), std::fabs(s.p1.y)));
+      }
+
+      m_epsilon = std::max(extent, 1.0) * 1.e-7;
+
+      m_starts.resize(m_segments.size());
+      for (uint32_t i = 0; i < (uint32_t)m_segments.size(); i++)
+        m_starts[i] = i;
+      std::sort(m_starts.begin(), m_starts.end(), [this](uint32_t a, uint32_t b)
+        { return PointLess(m_segments[a].p0, m_segments[b].p0); });
+
+      for (auto const &s : m_segments)
+      {
+        m_events.insert(s.p0);
+        m_events.insert(s.p1);
+      }
+    }
+
+    double Sweep::HeightAt(uint32_t id) const
+    {
+      Segment const &s = m_segments[id];
+      if (s.p0.x == s.p1.x)
+        return std::min(std::max(m_point.y, s.p0.y), s.p1.y);
+
+      double x = std::min(std::max(m_point.x, s.p0.x), s.p1.x);
+      return s.p0.y + (x - s.p0.x) * s.slope;
+    }
+
+    bool Sweep::Below(uint32_t a, uint32_t b) const
+    {
+      if (a == b)
+        return false;
+
+      double ya = HeightAt(a);
+      double yb = HeightAt(b);
+      if (ya < yb - m_epsilon) return true;
+      if (ya > yb + m_epsilon) return false;
+
+      double sa = m_segments[a].slope;
+      double sb = m_segments[b].slope;
+      if (sa != sb)
+        return sa < sb;
+      return a < b;
+    }
+
+    bool Sweep::Near(SweepPoint const &a, SweepPoint const &b) const
+    {
+      return std::fabs(a.x - b.x) <= m_epsilon && std::fabs(a.y - b.y) <= m_epsilon;
+    }
+
+    void Sweep::Check(uint32_t a, uint32_t b)
+    {
+      Segment const &s = m_segments[a];
+      Segment const &t = m_segments[b];
+
+      double rx = s.p1.x - s.p0.x;
+      double ry = s.p1.y - s.p0.y;
+      double qx = t.p1.x - t.p0.x;
+      double qy = t.p1.y - t.p0.y;
+
+      // Parallel segments can only overlap, and overlaps start and end at segment
+      // end points, which are already events.
+      double denom = Cross(rx, ry, qx, qy);
+      if (std::fabs(denom) <= DBL_EPSILON * (std::fabs(rx * qy) + std::fabs(ry * qx)))
+        return;
+
+      double wx = t.p0.x - s.p0.x;
+      double wy = t.p0.y - s.p0.y;
+      double u = Cross(wx, wy, qx, qy) / denom;
+      double v = Cross(wx, wy, rx, ry) / denom;
+      if (u < 0.0 || u > 1.0 || v < 0.0 || v > 1.0)
+        return;
+
+      SweepPoint p = {s.p0.x + u * rx, s.p0.y + u * ry};
+      if (PointLess(m_point, p) && !Near(m_point, p))
+        m_events.insert(p);
+    }
+
+    void Sweep::Run(SweepCallback const &callback)
+    {
+      std::vector<uint32_t> group;
+      std::vector<uint32_t> reinsert;
+      size_t nextStart = 0;
+
+      while (!m_events.empty())
+      {
+        m_point = *m_events.begin();
+        m_events.erase(m_events.begin());
+
+        group.clear();
+        reinsert.clear();
+
+        // Segments starting here.
+        while (nextStart < m_starts.size())
+        {
+          Segment const &s = m_segments[m_starts[nextStart]];
+          if (!PointLess(s.p0, m_point) && !Near(s.p0, m_point))
+            break;
+          group.push_back(m_starts[nextStart]);
+          reinsert.push_back(m_starts[nextStart]);
+          nextStart++;
+        }
+
+        // Segments in the status that end at, or pass through, this point. They
+        // are contiguous in the status.
+        auto first = m_status.lower_bound(m_point.y - m_epsilon);
+        auto last = first;
+        while (last != m_status.end() && HeightAt(*last) <= m_point.y + m_epsilon)
+        {
+          group.push_back(*last);
+          if (!Near(m_segments[*last].p1, m_point))
+            reinsert.push_back(*last);
+          last++;
+        }
+
+        if (group.size() > 1)
+        {
+          if (!callback(m_point, group.data(), group.size()))
+            return;
+        }
+
+        bool hasBelow = first != m_status.begin();
+        uint32_t below = hasBelow ? *std::prev(first) : 0;
+        m_status.erase(first, last);
+
+        for (uint32_t id : reinsert)
+          m_status.insert(id);
+
+        if (reinsert.empty())
+        {
+          if (hasBelow && last != m_status.end())
+            Check(below, *last);
+          continue;
+        }
+
+        auto lowest = m_status.lower_bound(m_point.y - m_epsilon);
+        auto highest = lowest;
+        while (std::next(highest) != m_status.end() && HeightAt(*std::next(highest)) <= m_point.y + m_epsilon)
+          highest++;
+
+        if (lowest != m_status.begin())
+          Check(*std::prev(lowest), *lowest);
+        if (std::next(highest) != m_status.end())
+          Check(*highest, *std::next(highest));
+      }
+    }
+  }
+
+  void SweepIntersections(std::vector<SweepSegment> const &segments, SweepCallback const &callback)
+  {
+    XN_TRACE_SCOPE("Common", "SweepIntersections");
+    Sweep sweep(segments);
+    sweep.Run(callback);
+  }
+
+  void FindLoopIntersections(std::vector<std::vector<SweepPoint>> const &loops, LoopPairCallback const &callback)
+  {
+    struct EdgeInfo
+    {
+      uint32_t loop;
+      uint32_t index;
+    };
+
+    std::vector<SweepSegment> segments;
+    std::vector<EdgeInfo> info;
+    double extent = 0.0;
+    for (uint32_t l = 0; l < (uint32_t)loops.size(); l++)
+    {
+      std::vector<SweepPoint> const &loop = loops[l];
+      for (uint32_t i = 0; i < (uint32_t)loop.size(); i++)
+      {
+        SweepSegment s = {loop[i], loop[(i + 1) % loop.size()]};
+        segments.push_back(s);
+        info.push_back(EdgeInfo{l, i});
+        extent = std::max(extent, std::max(std::fabs(loop[i].x), std::fabs(loop[i].y)));
+      }
+    }
+    double tolerance = std::max(extent, 1.0) * 1.e-7;
+
+    SweepIntersections(segments, [&](SweepPoint const &point, uint32_t const *pSegments, size_t count)
+    {
+      // The only allowed meeting is two neighbouring edges at their shared vertex.
+      if (count == 2)
+      {
+        EdgeInfo a = info[pSegments[0]];
+        EdgeInfo b = info[pSegments[1]];
+        if (a.loop == b.loop)
+        {
+          uint32_t size = (uint32_t)loops[a.loop].size();
+          uint32_t shared = 0xFFFFFFFF;
+          if ((a.index + 1) % size == b.index)
+            shared = b.index;
+          else if ((b.index + 1) % size == a.index)
+            shared = a.index;
+
+          if (shared != 0xFFFFFFFF && size > 2)
+          {
+            SweepPoint const &v = loops[a.loop][shared];
+            if (std::fabs(v.x - point.x) <= tolerance && std::fabs(v.y - point.y) <= tolerance)
+              return true;
+          }
+        }
+      }
+
+      for (size_t i = 0; i < count; i++)
+      {
+        for (size_t j = i + 1; j < count; j++)
+        {
+          if (!callback(info[pSegments[i]].loop, info[pSegments[j]].loop))
+            return false;
+        }
+      }
+      return true;
+    });
+  }
+
+  bool LoopsIntersect(std::vector<std::vector<SweepPoint>> const &loops)
+  {
+    bool intersects = false;
+    FindLoopIntersections(loops, [&](uint32_t, uint32_t)
+    {
+      intersects = true;
+      return false;
+    });
+    return intersects;
+  }
+}
\ No newline at end of file
@@ -0,0 +1,45 @@
+#ifndef SEGMENTSWEEP_H
+#define SEGMENTSWEEP_H
+
+#include <stdint.h>
+#include <vector>
+#include <functional>
+
+#include "CommonAPI.h"
+
+namespace Common
+{
+  struct SweepPoint
+  {
+    double x;
+    double y;
+  };
+
+  struct SweepSegment
+  {
+    SweepPoint p0;
+    SweepPoint p1;
+  };
+
+  // Called for every point where two or more segments meet, with the indices of
+  // those segments. This includes segments that only start or end at the point.
+  // Return false to stop the sweep.
+  typedef std::function<bool(SweepPoint const &, uint32_t const *pSegments, size_t count)> SweepCallback;
+
+  // Bentley-Ottmann sweep. Runs in O((n + k) log n) for n segments and k meeting points.
+  COMMON_API void SweepIntersections(std::vector<SweepSegment> const &segments, SweepCallback const &callback);
+
+  // Called with the loops of every two edges that touch or cross. Return false to stop.
+  typedef std::function<bool(uint32_t loopA, uint32_t loopB)> LoopPairCallback;
+
+  // Reports every two edges of the loops that touch or cross, other than neighbouring
+  // edges of a loop meeting at their shared vertex.
+  COMMON_API void FindLoopIntersections(std::vector<std::vector<SweepPoint>> const &loops, LoopPairCallback const &callback);
+
+  // True if any two edges of the loops touch or cross, other than neighbouring
+  // edges of a loop meeting at their shared vertex. Stops at the first hit, so this
+  // runs in O(n log n).
+  COMMON_API bool LoopsIntersect(std::vector<std::vector<SweepPoint>> const &loops);
+}
+
+#endif
\ No newline at end of file
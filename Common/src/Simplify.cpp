@@ -0,0 +1,359 @@
+
+#include <chrono>
+#include <cmath>
+#include <algorithm>
+#include <unordered_set>
+
+#include "Simplify.h"
+#include "SegmentSweep.h"
+#include "ThreadPool.h"
+#include "Trace.h"
+
+namespace Common
+{
+  namespace
+  {
+    // Largest sine of the turn angle at a vertex that still counts as collinear.
+    double const s_collinearEpsilon = 1.e-6;
+
+    // Halvings of the tolerance tried for a loop that crosses another edge,
+    // before it falls back to a tolerance of 0.
+    int const s_maxHalvings = 3;
+
+    struct Point
+    {
+      double x;
+      double y;
+    };
+
+    double Distance(Point const &a, Point const &b)
+    {
+      return std::hypot(b.x - a.x, b.y - a.y);
+    }
+
+    bool Collinear(Point const &a, Point const &b, Point const &c)
+    {
+      double ux = b.x - a.x, uy = b.y - a.y;
+      double vx = c.x - b.x, vy = c.y - b.y;
+      double cross = ux * vy - uy * vx;
+      return std::fabs(cross) <= s_collinearEpsilon * std::hypot(ux, uy) * std::hypot(vx, vy);
+    }
+
+    double SegmentDistance(Point const &p, Point const &a, Point const &b)
+    {
+      double dx = b.x - a.x, dy = b.y - a.y;
+      double lengthSq = dx * dx + dy * dy;
+      if (lengthSq == 0.0)
+        return Distance(p, a);
+      double t = std::max(0.0, std::min(1.0, ((p.x - a.x) * dx + (p.y - a.y) * dy) / lengthSq));
+      Point q = {a.x + t * dx, a.y + t * dy};
+      return Distance(p, q);
+    }
+
+    // Snaps runs of vertices closer than the tolerance to the first of the run, then
+    // removes collinear vertices with a stack, so each vertex is pushed and popped once.
+    void CleanLoop(xn::PolygonLoop const &loop, double tolerance, std::vector<Point> *pOut)
+    {
+      std::vector<Point> &out = *pOut;
+      out.clear();
+      for (auto it = loop.cPointsBegin(); it != loop.cPointsEnd(); it++)
+      {
+        Point p = {(double)it->x(), (double)it->y()};
+        if (!out.empty() && Distance(out.back(), p) <= tolerance)
+          continue;
+
+        while (out.size() >= 2 && Collinear(out[out.size() - 2], out.back(), p))
+          out.pop_back();
+        out.push_back(p);
+      }
+
+      while (out.size() > 1 && Distance(out.back(), out.front()) <= tolerance)
+        out.pop_back();
+
+      // Collinear runs through the start of the loop.
+      size_t first = 0;
+      while (out.size() - first >= 3)
+      {
+        if (Collinear(out[out.size() - 2], out.back(), out[first]))
+          out.pop_back();
+        else if (Collinear(out.back(), out[first], out[first + 1]))
+          first++;
+        else
+          break;
+      }
+      out.erase(out.begin(), out.begin() + first);
+    }
+
+    // Douglas-Peucker on a closed loop, splitting it at vertex 0 and the vertex
+    // furthest from it. Both halves keep their furthest vertex whatever the
+    // tolerance, so the result never collapses below 3 vertices.
+    //
+    // Plain Douglas-Peucker is O(n^2) when each split peels a single vertex off a
+    // range, e.g. on a spiral. Ranges at the same depth are disjoint, so each level
+    // costs O(n); past MaxDepth levels ranges are halved instead of split at their
+    // furthest vertex, which bounds the whole run to O(n log n). Halving still only
+    // drops vertices within the tolerance, it may just keep a few more of them.
+    void DouglasPeucker(std::vector<Point> const &points, double tolerance, std::vector<bool> *pKeep)
+    {
+      size_t n = points.size();
+      std::vector<bool> &keep = *pKeep;
+      keep.assign(n, false);
+
+      size_t split = 0;
+      double furthest = 0.0;
+      for (size_t i = 1; i < n; i++)
+      {
+        double d = Distance(points[0], points[i]);
+        if (d > furthest)
+        {
+          furthest = d;
+          split = i;
+        }
+      }
+      keep[0] = true;
+      keep[split] = true;
+
+      struct Range
+      {
+        size_t first;
+        size_t last;   // May be n, meaning vertex 0
+        bool force;
+        uint32_t depth;
+      };
+
+      uint32_t maxDepth = 2;
+      for (size_t size = n; size > 1; size >>= 1)
+        maxDepth += 2;
+
+      std::vector<Range> stack;
+      stack.push_back(Range{0, split, true, 0});
+      stack.push_back(Range{split, n, true, 0});
+      while (!stack.empty())
+      {
+        Range range = stack.back();
+        stack.pop_back();
+
+        Point const &a = points[range.first];
+        Point const &b = points[range.last % n];
+        size_t index = 0;
+        double maxDistance = -1.0;
+        for (size_t i = range.first + 1; i < range.last; i++)
+        {
+          double d = SegmentDistance(points[i], a, b);
+          if (d > maxDistance)
+          {
+            maxDistance = d;
+            index = i;
+          }
+        }
+
+        if (index == 0 || (!range.force && maxDistance <= tolerance))
+          continue;
+
+        if (range.depth >= maxDepth)
+          index = range.first + (range.last - range.first) / 2;
+
+        keep[index] = true;
+        stack.push_back(Range{range.first, index, false, range.depth + 1});
+        stack.push_back(Range{index, range.last, false, range.depth + 1});
+      }
+    }
+
+    uint64_t LoopPairKey(uint32_t a, uint32_t b)
+    {
+      return a < b ? ((uint64_t)a << 32) | b : ((uint64_t)b << 32) | a;
+    }
+
+    // Sweep input for the non-empty loops, and the index of the loop each came from.
+    void ToSweepLoops(std::vector<xn::PolygonLoop> const &loops, std::vector<std::vector<SweepPoint>> *pSweepLoops,
+                      std::vector<uint32_t> *pSweepToLoop)
+    {
+      pSweepLoops->clear();
+      pSweepToLoop->clear();
+      for (size_t i = 0; i < loops.size(); i++)
+      {
+        if (loops[i].Size() == 0)
+          continue;
+        pSweepLoops->push_back(std::vector<SweepPoint>());
+        for (auto it = loops[i].cPointsBegin(); it != loops[i].cPointsEnd(); it++)
+          pSweepLoops->back().push_back(SweepPoint{(double)it->x(), (double)it->y()});
+        pSweepToLoop->push_back((uint32_t)i);
+      }
+    }
+
+    void SimplifyLoop(xn::PolygonLoop const &loop, double tolerance, xn::PolygonLoop *pOut)
+    {
+      std::vector<Point> points;
+      CleanLoop(loop, tolerance, &points);
+
+      pOut->Clear();
+      if (points.size() < 3)
+        return;
+
+      std::vector<bool> keep(points.size(), true);
+      if (tolerance > 0.0)
+        DouglasPeucker(points, tolerance, &keep);
+
+      for (size_t i = 0; i < points.size(); i++)
+      {
+        if (keep[i])
+          pOut->PushBack(xn::vec2((float)points[i].x, (float)points[i].y));
+      }
+    }
+  }
+
+  class Simplifier::PIMPL
+  {
+  public:
+
+    PIMPL()
+      : tolerance(0.f)
+      , stats{}
+    {
+
+    }
+
+    void Run();
+
+    float tolerance;
+    std::vector<xn::PolygonLoop> input;
+    std::vector<xn::PolygonLoop> output;
+    SimplifyStats stats;
+  };
+
+  void Simplifier::PIMPL::Run()
+  {
+    XN_TRACE_SCOPE("Common", "Simplify");
+    auto start = std::chrono::high_resolution_clock::now();
+
+    size_t loopCount = input.size();
+    std::vector<xn::PolygonLoop> loops(loopCount);
+    std::vector<double> tolerances(loopCount, (double)tolerance);
+    ThreadPool &pool = ThreadPool::Shared();
+    pool.ParallelFor(loopCount, [&](size_t i, uint32_t)
+    {
+      SimplifyLoop(input[i], tolerances[i], &loops[i]);
+    }, "Simplify");
+
+    // Edges moved by the simplification may now touch other edges. Loops that
+    // already touch in the input, as overlapping inputs do by design, are left
+    // alone: only pairs of loops that did not touch before are blamed, and of those
+    // only the loops that lost vertices. New crossings between two loops that
+    // already touched are not caught.
+    std::vector<std::vector<SweepPoint>> sweepLoops;
+    std::vector<uint32_t> sweepToLoop;
+    std::unordered_set<uint64_t> inputPairs;
+    if (tolerance > 0.f)
+    {
+      ToSweepLoops(input, &sweepLoops, &sweepToLoop);
+      FindLoopIntersections(sweepLoops, [&](uint32_t a, uint32_t b)
+      {
+        inputPairs.insert(LoopPairKey(sweepToLoop[a], sweepToLoop[b]));
+        return true;
+      });
+    }
+
+    size_t restored = 0;
+    for (int round = 0; tolerance > 0.f && round <= s_maxHalvings; round++)
+    {
+      ToSweepLoops(loops, &sweepLoops, &sweepToLoop);
+
+      std::vector<bool> offending(loopCount, false);
+      bool found = false;
+      FindLoopIntersections(sweepLoops, [&](uint32_t a, uint32_t b)
+      {
+        uint32_t loopA = sweepToLoop[a];
+        uint32_t loopB = sweepToLoop[b];
+        if (inputPairs.count(LoopPairKey(loopA, loopB)) != 0)
+          return true;
+        if (loops[loopA].Size() < input[loopA].Size())
+          offending[loopA] = found = true;
+        if (loops[loopB].Size() < input[loopB].Size())
+          offending[loopB] = found = true;
+        return true;
+      });
+      if (!found)
+        break;
+
+      std::vector<size_t> redo;
+      for (size_t i = 0; i < loopCount; i++)
+      {
+        if (!offending[i])
+          continue;
+        if (tolerances[i] == (double)tolerance)
+          restored++;
+        tolerances[i] = round == s_maxHalvings ? 0.0 : tolerances[i] * 0.5;
+        redo.push_back(i);
+      }
+
+      pool.ParallelFor(redo.size(), [&](size_t r, uint32_t)
+      {
+        SimplifyLoop(input[redo[r]], tolerances[redo[r]], &loops[redo[r]]);
+      }, "Simplify");
+    }
+
+    stats = SimplifyStats{};
+    output.clear();
+    for (size_t i = 0; i < loopCount; i++)
+    {
+      stats.inputVertices += input[i].Size();
+      if (loops[i].Size() == 0)
+      {
+        stats.droppedLoops++;
+        continue;
+      }
+      stats.outputVertices += loops[i].Size();
+      output.push_back(loops[i]);
+    }
+    stats.restoredLoops = restored;
+    stats.ms = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+  }
+
+  //----------------------------------------------------------------
+  // Simplifier
+  //----------------------------------------------------------------
+
+  Simplifier::Simplifier()
+    : m_pimpl(new PIMPL())
+  {
+
+  }
+
+  Simplifier::~Simplifier()
+  {
+    delete m_pimpl;
+  }
+
+  void Simplifier::SetTolerance(float tolerance)
+  {
+    m_pimpl->tolerance = std::max(tolerance, 0.f);
+  }
+
+  float Simplifier::GetTolerance() const
+  {
+    return m_pimpl->tolerance;
+  }
+
+  std::vector<xn::PolygonLoop> const &Simplifier::Run(std::vector<xn::PolygonLoop> const &loops)
+  {
+    if (&loops != &m_pimpl->input)
+      m_pimpl->input = loops;
+    m_pimpl->Run();
+    return m_pimpl->output;
+  }
+
+  std::vector<xn::PolygonLoop> const &Simplifier::GetInput() const
+  {
+    return m_pimpl->input;
+  }
+
+  std::vector<xn::PolygonLoop> const &Simplifier::GetOutput() const
+  {
+    return m_pimpl->output;
+  }
+
+  SimplifyStats const &Simplifier::GetStats() const
+  {
+    return m_pimpl->stats;
+  }
+}
\ No newline at end of file
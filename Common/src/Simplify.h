@@ -0,0 +1,62 @@
+#ifndef SIMPLIFY_H
+#define SIMPLIFY_H
+
+#include <stddef.h>
+#include <vector>
+
+#include "CommonAPI.h"
+#include "xnGeometry.h"
+
+namespace Common
+{
+  struct SimplifyStats
+  {
+    size_t inputVertices;
+    size_t outputVertices;
+    size_t droppedLoops;    // Loops with fewer than 3 distinct vertices
+    size_t restoredLoops;   // Loops simplified less so they would not cross another edge
+    float ms;
+  };
+
+  // Preprocessing stage modules run on their input loops. Each loop has its
+  // near-duplicate vertices snapped together and collinear vertices removed, and is
+  // then Douglas-Peucker simplified, all to within the tolerance. Loops are done in
+  // parallel on the shared pool. A loop whose result touches a loop it did not touch
+  // in the input is redone with half the tolerance, and finally with none. Loops that
+  // already touch in the input, eg overlapping polygons, are simplified as usual.
+  //
+  // A tolerance of 0 only removes exact duplicates and collinear vertices.
+  //
+  // Cleaning is O(n) per loop. Douglas-Peucker has its recursion depth bounded, so it
+  // is O(n log n) in the worst case rather than O(n^2). The topology check is a sweep
+  // over all edges, O((n + k) log n) for k intersections, once on the input and once
+  // per retry round.
+  class COMMON_API Simplifier
+  {
+  public:
+
+    Simplifier();
+    ~Simplifier();
+
+    Simplifier(Simplifier const &) = delete;
+    Simplifier &operator=(Simplifier const &) = delete;
+
+    void SetTolerance(float tolerance);
+    float GetTolerance() const;
+
+    // Returns the simplified loops, valid until the next call. A copy of the input
+    // is kept, so Run(GetInput()) redoes the last run, e.g. after a tolerance change.
+    std::vector<xn::PolygonLoop> const &Run(std::vector<xn::PolygonLoop> const &loops);
+
+    std::vector<xn::PolygonLoop> const &GetInput() const;
+    std::vector<xn::PolygonLoop> const &GetOutput() const;
+    SimplifyStats const &GetStats() const;
+
+  private:
+
+    class PIMPL;
+    PIMPL *m_pimpl;
+  };
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,718 @@
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <cmath>
+#include <algorithm>
+
+#include "SvgImport.h"
+
+namespace Common
+{
+  namespace
+  {
+    double const s_pi = 3.14159265358979323846;
+    int const s_maxCurveSegments = 1024;
+
+    struct Point
+    {
+      double x;
+      double y;
+    };
+
+    //----------------------------------------------------------------
+    // Streams the file and returns one tag at a time, skipping text,
+    // comments and declarations.
+    //----------------------------------------------------------------
+    class TagReader
+    {
+    public:
+
+      TagReader(FILE *pFile)
+        : m_pFile(pFile)
+        , m_pos(0)
+        , m_size(0)
+      {
+
+      }
+
+      // The text between '<' and '>'. False at the end of the file.
+      bool NextTag(std::string *pTag);
+
+    private:
+
+      int Next()
+      {
+        if (m_pos == m_size)
+        {
+          m_size = fread(m_buffer, 1, sizeof(m_buffer), m_pFile);
+          m_pos = 0;
+          if (m_size == 0)
+            return -1;
+        }
+        return (unsigned char)m_buffer[m_pos++];
+      }
+
+      bool SkipComment();
+
+    private:
+
+      FILE *m_pFile;
+      char m_buffer[1 << 16];
+      size_t m_pos;
+      size_t m_size;
+    };
+
+    bool TagReader::SkipComment()
+    {
+      int dashes = 0;
+      for (int c = Next(); c != -1; c = Next())
+      {
+        if (c == '>' && dashes >= 2)
+          return true;
+        dashes = c == '-' ? dashes + 1 : 0;
+      }
+      return false;
+    }
+
+    bool TagReader::NextTag(std::string *pTag)
+    {
+      for (;;)
+      {
+        int c = Next();
+        while (c != '<' && c != -1)
+          c = Next();
+        if (c == -1)
+          return false;
+
+        pTag->clear();
+        char quote = 0;
+        for (c = Next(); c != -1; c = Next())
+        {
+          if (quote == 0 && c == '>')
+            break;
+          if (quote == 0 && (c == '"' || c == '\''))
+            quote = (char)c;
+          else if (c == quote)
+            quote = 0;
+          pTag->push_back((char)c);
+
+          if (pTag->size() == 3 && pTag->compare(0, 3, "!--") == 0)
+            break;
+        }
+        if (c == -1)
+          return false;
+
+        if (pTag->compare(0, 3, "!--") == 0)
+        {
+          if (!SkipComment())
+            return false;
+          continue;
+        }
+
+        if (pTag->empty() || (*pTag)[0] == '!' || (*pTag)[0] == '?' || (*pTag)[0] == '/')
+          continue;
+        return true;
+      }
+    }
+
+    bool IsSpace(char c)
+    {
+      return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+    }
+
+    // The local element name, without any namespace prefix.
+    std::string TagName(std::string const &tag)
+    {
+      size_t end = 0;
+      while (end < tag.size() && !IsSpace(tag[end]) && tag[end] != '/')
+        end++;
+      size_t colon = tag.rfind(':', end);
+      size_t begin = colon == std::string::npos ? 0 : colon + 1;
+      return tag.substr(begin, end - begin);
+    }
+
+    // Finds the value of an attribute. Returns a pointer into the tag and its length.
+    bool FindAttribute(std::string const &tag, char const *name, char const **ppValue, size_t *pLength)
+    {
+      size_t nameLength = strlen(name);
+      size_t i = 0;
+      while (i < tag.size() && !IsSpace(tag[i]))
+        i++;
+
+      while (i < tag.size())
+      {
+        while (i < tag.size() && IsSpace(tag[i]))
+          i++;
+        size_t nameBegin = i;
+        while (i < tag.size() && tag[i] != '=' && !IsSpace(tag[i]))
+          i++;
+        size_t nameEnd = i;
+        while (i < tag.size() && IsSpace(tag[i]))
+          i++;
+        if (i >= tag.size() || tag[i] != '=')
+          return false;
+        i++;
+        while (i < tag.size() && IsSpace(tag[i]))
+          i++;
+        if (i >= tag.size() || (tag[i] != '"' && tag[i] != '\''))
+          return false;
+
+        char quote = tag[i++];
+        size_t valueBegin = i;
+        while (i < tag.size() && tag[i] != quote)
+          i++;
+
+        if (nameEnd - nameBegin == nameLength && tag.compare(nameBegin, nameLength, name) == 0)
+        {
+          *ppValue = tag.c_str() + valueBegin;
+          *pLength = i - valueBegin;
+          return true;
+        }
+        i++;
+      }
+      return false;
+    }
+
+    //----------------------------------------------------------------
+    // Turns path commands into flattened loops.
+    //----------------------------------------------------------------
+    class LoopBuilder
+    {
+    public:
+
+      LoopBuilder(float tolerance, bool flipVertical, std::vector<xn::PolygonLoop> *pLoops)
+        : m_tolerance(std::max((double)tolerance, 1.e-6))
+        , m_flip(flipVertical ? -1.0 : 1.0)
+        , m_pLoops(pLoops)
+        , m_points()
+      {
+
+      }
+
+      void MoveTo(Point const &p);
+      void LineTo(Point const &p);
+      void QuadTo(Point const &p0, Point const &c, Point const &p);
+      void CubicTo(Point const &p0, Point const &c0, Point const &c1, Point const &p);
+      void ArcTo(Point const &p0, double rx, double ry, double rotation, bool largeArc, bool sweep, Point const &p);
+      void Finish();
+
+    private:
+
+      int SegmentCount(double secondDifference, double factor) const;
+
+    private:
+
+      double m_tolerance;
+      double m_flip;
+      std::vector<xn::PolygonLoop> *m_pLoops;
+      std::vector<Point> m_points;
+    };
+
+    void LoopBuilder::MoveTo(Point const &p)
+    {
+      Finish();
+      m_points.push_back(p);
+    }
+
+    void LoopBuilder::LineTo(Point const &p)
+    {
+      if (!m_points.empty() && m_points.back().x == p.x && m_points.back().y == p.y)
+        return;
+      m_points.push_back(p);
+    }
+
+    // Wang's bound: a curve of degree d split into n equal parameter steps lies within
+    // d(d - 1)/8 * max|second difference| / n^2 of its chords.
+    int LoopBuilder::SegmentCount(double secondDifference, double factor) const
+    {
+      double n = std::ceil(std::sqrt(factor * secondDifference / m_tolerance));
+      return (int)std::min(std::max(n, 1.0), (double)s_maxCurveSegments);
+    }
+
+    void LoopBuilder::QuadTo(Point const &p0, Point const &c, Point const &p)
+    {
+      double d = std::hypot(p0.x - 2.0 * c.x + p.x, p0.y - 2.0 * c.y + p.y);
+      int n = SegmentCount(d, 0.25);
+      for (int i = 1; i < n; i++)
+      {
+        double t = (double)i / (double)n;
+        double s = 1.0 - t;
+        LineTo(Point{s * s * p0.x + 2.0 * s * t * c.x + t * t * p.x,
+                     s * s * p0.y + 2.0 * s * t * c.y + t * t * p.y});
+      }
+      LineTo(p);
+    }
+
+    void LoopBuilder::CubicTo(Point const &p0, Point const &c0, Point const &c1, Point const &p)
+    {
+      double d0 = std::hypot(p0.x - 2.0 * c0.x + c1.x, p0.y - 2.0 * c0.y + c1.y);
+      double d1 = std::hypot(c0.x - 2.0 * c1.x + p.x, c0.y - 2.0 * c1.y + p.y);
+      int n = SegmentCount(std::max(d0, d1), 0.75);
+      for (int i = 1; i < n; i++)
+      {
+        double t = (double)i / (double)n;
+        double s = 1.0 - t;
+        double a = s * s * s;
+        double b = 3.0 * s * s * t;
+        double e = 3.0 * s * t * t;
+        double f = t * t * t;
+        LineTo(Point{a * p0.x + b * c0.x + e * c1.x + f * p.x,
+                     a * p0.y + b * c0.y + e * c1.y + f * p.y});
+      }
+      LineTo(p);
+    }
+
+    // Endpoint to centre conversion, from the SVG implementation notes.
+    void LoopBuilder::ArcTo(Point const &p0, double rx, double ry, double rotation, bool largeArc, bool sweep, Point const &p)
+    {
+      rx = std::fabs(rx);
+      ry = std::fabs(ry);
+      if (rx == 0.0 || ry == 0.0 || (p0.x == p.x && p0.y == p.y))
+      {
+        LineTo(p);
+        return;
+      }
+
+      double phi = rotation * s_pi / 180.0;
+      double cosPhi = std::cos(phi);
+      double sinPhi = std::sin(phi);
+
+      double dx = (p0.x - p.x) * 0.5;
+      double dy = (p0.y - p.y) * 0.5;
+      double x1 = cosPhi * dx + sinPhi * dy;
+      double y1 = -sinPhi * dx + cosPhi * dy;
+
+      // Scale up radii that cannot span the end points.
+      double lambda = (x1 * x1) / (rx * rx) + (y1 * y1) / (ry * ry);
+      if (lambda > 1.0)
+      {
+        rx *= std::sqrt(lambda);
+        ry *= std::sqrt(lambda);
+      }
+
+      double rx2 = rx * rx;
+      double ry2 = ry * ry;
+      double num = rx2 * ry2 - rx2 * y1 * y1 - ry2 * x1 * x1;
+      double den = rx2 * y1 * y1 + ry2 * x1 * x1;
+      double coef = std::sqrt(std::max(0.0, num / den)) * (largeArc == sweep ? -1.0 : 1.0);
+      double cxp = coef * rx * y1 / ry;
+      double cyp = -coef * ry * x1 / rx;
+      double cx = cosPhi * cxp - sinPhi * cyp + (p0.x + p.x) * 0.5;
+      double cy = sinPhi * cxp + cosPhi * cyp + (p0.y + p.y) * 0.5;
+
+      double theta = std::atan2((y1 - cyp) / ry, (x1 - cxp) / rx);
+      double delta = std::atan2((-y1 - cyp) / ry, (-x1 - cxp) / rx) - theta;
+      if (sweep && delta < 0.0)
+        delta += 2.0 * s_pi;
+      else if (!sweep && delta > 0.0)
+        delta -= 2.0 * s_pi;
+
+      double r = std::max(rx, ry);
+      double maxStep = m_tolerance < r ? 2.0 * std::acos(1.0 - m_tolerance / r) : s_pi * 0.5;
+      int n = (int)std::min(std::max(std::ceil(std::fabs(delta) / maxStep), 1.0), (double)s_maxCurveSegments);
+      for (int i = 1; i < n; i++)
+      {
+        double t = theta + delta * (double)i / (double)n;
+        double ct = std::cos(t);
+        double st = std::sin(t);
+        LineTo(Point{cx + rx * ct * cosPhi - ry * st * sinPhi,
+                     cy + rx * ct * sinPhi + ry * st * cosPhi});
+      }
+      LineTo(p);
+    }
+
+    void LoopBuilder::Finish()
+    {
+      if (m_points.size() > 1 && m_points.front().x == m_points.back().x && m_points.front().y == m_points.back().y)
+        m_points.pop_back();
+
+      if (m_points.size() >= 3)
+      {
+        m_pLoops->push_back(xn::PolygonLoop());
+        xn::PolygonLoop &loop = m_pLoops->back();
+        for (auto const &p : m_points)
+          loop.PushBack(xn::vec2((float)p.x, (float)(p.y * m_flip)));
+      }
+      m_points.clear();
+    }
+
+    //----------------------------------------------------------------
+    // Path data
+    //----------------------------------------------------------------
+    class PathParser
+    {
+    public:
+
+      PathParser(char const *pBegin, char const *pEnd)
+        : m_pBegin(pBegin)
+        , m_p(pBegin)
+        , m_pEnd(pEnd)
+      {
+
+      }
+
+      // Stops at the first error, keeping what came before, as SVG renderers do.
+      // Returns false if it stopped early.
+      bool Parse(LoopBuilder *pBuilder);
+
+      // For <polygon points="...">.
+      bool ParsePoints(LoopBuilder *pBuilder);
+
+      // Where parsing stopped, from the start of the attribute value.
+      size_t Offset() const { return (size_t)(m_p - m_pBegin); }
+
+    private:
+
+      void SkipSeparators()
+      {
+        while (m_p < m_pEnd && (IsSpace(*m_p) || *m_p == ','))
+          m_p++;
+      }
+
+      bool AtNumber()
+      {
+        SkipSeparators();
+        return m_p < m_pEnd && ((*m_p >= '0' && *m_p <= '9') || *m_p == '-' || *m_p == '+' || *m_p == '.');
+      }
+
+      bool Number(double *pOut);
+      bool Flag(bool *pOut);
+      bool Coord(Point *pOut) { return Number(&pOut->x) && Number(&pOut->y); }
+
+    private:
+
+      char const *m_pBegin;
+      char const *m_p;
+      char const *m_pEnd;
+    };
+
+    bool PathParser::Number(double *pOut)
+    {
+      if (!AtNumber())
+        return false;
+
+      // Copy out the number, as strtod would read past the end of the attribute.
+      char buffer[64];
+      size_t length = 0;
+      char const *p = m_p;
+      if (p < m_pEnd && (*p == '-' || *p == '+'))
+        buffer[length++] = *p++;
+      bool dot = false;
+      bool digits = false;
+      while (p < m_pEnd && length < sizeof(buffer) - 8 && ((*p >= '0' && *p <= '9') || (*p == '.' && !dot)))
+      {
+        dot = dot || *p == '.';
+        digits = digits || *p != '.';
+        buffer[length++] = *p++;
+      }
+      if (!digits)
+        return false;
+
+      if (p < m_pEnd && (*p == 'e' || *p == 'E'))
+      {
+        char const *pExp = p + 1;
+        if (pExp < m_pEnd && (*pExp == '-' || *pExp == '+'))
+          pExp++;
+        if (pExp < m_pEnd && *pExp >= '0' && *pExp <= '9')
+        {
+          while (p < pExp)
+            buffer[length++] = *p++;
+          while (p < m_pEnd && *p >= '0' && *p <= '9' && length < sizeof(buffer) - 1)
+            buffer[length++] = *p++;
+        }
+      }
+      buffer[length] = '\0';
+
+      *pOut = strtod(buffer, nullptr);
+      m_p = p;
+      return true;
+    }
+
+    // Arc flags are a single digit and need no separator after them.
+    bool PathParser::Flag(bool *pOut)
+    {
+      SkipSeparators();
+      if (m_p >= m_pEnd || (*m_p != '0' && *m_p != '1'))
+        return false;
+      *pOut = *m_p == '1';
+      m_p++;
+      return true;
+    }
+
+    bool PathParser::Parse(LoopBuilder *pBuilder)
+    {
+      Point current = {0.0, 0.0};
+      Point start = {0.0, 0.0};
+      Point lastControl = {0.0, 0.0};
+      char command = 0;
+      char previous = 0;
+      bool ok = true;
+
+      for (;;)
+      {
+        SkipSeparators();
+        if (m_p >= m_pEnd)
+          break;
+
+        char const *pCommand = m_p;
+        if ((*m_p >= 'a' && *m_p <= 'z') || (*m_p >= 'A' && *m_p <= 'Z'))
+        {
+          command = *m_p++;
+        }
+        else if (command == 0 || command == 'z' || command == 'Z')
+        {
+          // Numbers must follow a command, and Z takes none.
+          ok = false;
+          break;
+        }
+
+        bool relative = command >= 'a' && command <= 'z';
+        Point origin = relative ? current : Point{0.0, 0.0};
+        Point p, c0, c1;
+
+        switch (command)
+        {
+          case 'M':
+          case 'm':
+          {
+            ok = Coord(&p);
+            if (!ok)
+              break;
+            p = Point{origin.x + p.x, origin.y + p.y};
+            pBuilder->MoveTo(p);
+            start = p;
+            current = p;
+
+            // Further pairs are implicit line-tos.
+            command = relative ? 'l' : 'L';
+            previous = command;
+            lastControl = current;
+            continue;
+          }
+          case 'L':
+          case 'l':
+          {
+            ok = Coord(&p);
+            if (ok)
+            {
+              p = Point{origin.x + p.x, origin.y + p.y};
+              pBuilder->LineTo(p);
+            }
+            break;
+          }
+          case 'H':
+          case 'h':
+          {
+            double x = 0.0;
+            ok = Number(&x);
+            p = Point{origin.x + x, current.y};
+            if (ok)
+              pBuilder->LineTo(p);
+            break;
+          }
+          case 'V':
+          case 'v':
+          {
+            double y = 0.0;
+            ok = Number(&y);
+            p = Point{current.x, (relative ? current.y : 0.0) + y};
+            if (ok)
+              pBuilder->LineTo(p);
+            break;
+          }
+          case 'C':
+          case 'c':
+          case 'S':
+          case 's':
+          {
+            bool smooth = command == 'S' || command == 's';
+            if (smooth)
+            {
+              bool follows = previous == 'C' || previous == 'c' || previous == 'S' || previous == 's';
+              c0 = follows ? Point{2.0 * current.x - lastControl.x, 2.0 * current.y - lastControl.y} : current;
+            }
+            else
+            {
+              ok = Coord(&c0);
+              c0 = Point{origin.x + c0.x, origin.y + c0.y};
+            }
+            ok = ok && Coord(&c1) && Coord(&p);
+            if (ok)
+            {
+              c1 = Point{origin.x + c1.x, origin.y + c1.y};
+              p = Point{origin.x + p.x, origin.y + p.y};
+              pBuilder->CubicTo(current, c0, c1, p);
+              lastControl = c1;
+            }
+            break;
+          }
+          case 'Q':
+          case 'q':
+          case 'T':
+          case 't':
+          {
+            bool smooth = command == 'T' || command == 't';
+            if (smooth)
+            {
+              bool follows = previous == 'Q' || previous == 'q' || previous == 'T' || previous == 't';
+              c0 = follows ? Point{2.0 * current.x - lastControl.x, 2.0 * current.y - lastControl.y} : current;
+            }
+            else
+            {
+              ok = Coord(&c0);
+              c0 = Point{origin.x + c0.x, origin.y + c0.y};
+            }
+            ok = ok && Coord(&p);
+            if (ok)
+            {
+              p = Point{origin.x + p.x, origin.y + p.y};
+              pBuilder->QuadTo(current, c0, p);
+              lastControl = c0;
+            }
+            break;
+          }
+          case 'A':
+          case 'a':
+          {
+            double rx = 0.0, ry = 0.0, rotation = 0.0;
+            bool largeArc = false, sweep = false;
+            ok = Number(&rx) && Number(&ry) && Number(&rotation) && Flag(&largeArc) && Flag(&sweep) && Coord(&p);
+            if (ok)
+            {
+              p = Point{origin.x + p.x, origin.y + p.y};
+              pBuilder->ArcTo(current, rx, ry, rotation, largeArc, sweep, p);
+            }
+            break;
+          }
+          case 'Z':
+          case 'z':
+          {
+            pBuilder->Finish();
+            p = start;
+            break;
+          }
+          default:
+            ok = false;
+        }
+
+        if (!ok)
+        {
+          // Report the error at the command that could not be read.
+          m_p = pCommand;
+          break;
+        }
+
+        current = p;
+        if (command != 'C' && command != 'c' && command != 'S' && command != 's' &&
+            command != 'Q' && command != 'q' && command != 'T' && command != 't')
+          lastControl = current;
+        previous = command;
+
+        // A sub-path that carries on after Z starts again at the same point.
+        if (command == 'Z' || command == 'z')
+        {
+          SkipSeparators();
+          if (m_p < m_pEnd && *m_p != 'M' && *m_p != 'm')
+            pBuilder->MoveTo(current);
+        }
+      }
+
+      pBuilder->Finish();
+      return ok;
+    }
+
+    bool PathParser::ParsePoints(LoopBuilder *pBuilder)
+    {
+      Point p;
+      bool first = true;
+      char const *pCoord = m_p;
+      while (Coord(&p))
+      {
+        if (first)
+          pBuilder->MoveTo(p);
+        else
+          pBuilder->LineTo(p);
+        first = false;
+        pCoord = m_p;
+      }
+      pBuilder->Finish();
+
+      // Only separators may follow the last whole coordinate pair.
+      m_p = pCoord;
+      SkipSeparators();
+      return m_p >= m_pEnd;
+    }
+  }
+
+  bool ImportSvg(char const *path, float tolerance, bool flipVertical,
+                 std::vector<xn::PolygonLoop> *pLoops, std::string *pError)
+  {
+    pLoops->clear();
+
+    FILE *pFile = fopen(path, "rb");
+    if (pFile == nullptr)
+    {
+      *pError = std::string("Unable to open '") + path + "'";
+      return false;
+    }
+
+    // Like an SVG renderer, keep going past malformed data, but fail the import so
+    // the first error is not lost.
+    LoopBuilder builder(tolerance, flipVertical, pLoops);
+    TagReader reader(pFile);
+    std::string tag;
+    std::string parseError;
+    size_t elements = 0;
+    while (reader.NextTag(&tag))
+    {
+      std::string name = TagName(tag);
+      char const *pValue = nullptr;
+      size_t length = 0;
+      bool ok = true;
+      PathParser parser(nullptr, nullptr);
+      if (name == "path" && FindAttribute(tag, "d", &pValue, &length))
+      {
+        parser = PathParser(pValue, pValue + length);
+        ok = parser.Parse(&builder);
+      }
+      else if (name == "polygon" && FindAttribute(tag, "points", &pValue, &length))
+      {
+        parser = PathParser(pValue, pValue + length);
+        ok = parser.ParsePoints(&builder);
+      }
+      else
+      {
+        continue;
+      }
+
+      elements++;
+      if (!ok && parseError.empty())
+      {
+        char buffer[128];
+        snprintf(buffer, sizeof(buffer), "<%s> element %zu: malformed data at offset %zu", name.c_str(), elements, parser.Offset());
+        parseError = buffer;
+      }
+    }
+
+    bool readError = ferror(pFile) != 0;
+    fclose(pFile);
+
+    if (readError)
+    {
+      *pError = std::string("Error reading '") + path + "'";
+      return false;
+    }
+    if (!parseError.empty())
+    {
+      *pError = std::string("Failed to parse '") + path + "': " + parseError;
+      return false;
+    }
+    if (pLoops->empty())
+    {
+      *pError = std::string("No loops found in '") + path + "'";
+      return false;
+    }
+    return true;
+  }
+}
\ No newline at end of file
@@ -0,0 +1,24 @@
+#ifndef SVGIMPORT_H
+#define SVGIMPORT_H
+
+#include <string>
+#include <vector>
+
+#include "CommonAPI.h"
+#include "xnGeometry.h"
+
+namespace Common
+{
+  // Reads the <path> and <polygon> elements of an SVG file in a single streaming
+  // pass. Every sub-path becomes one loop. The full path grammar is supported,
+  // with absolute and relative commands, and curves and arcs are flattened so no
+  // point of the curve lies further than 'tolerance' from the output. Transforms
+  // and styles are ignored. If flipVertical is set, y is negated, as SVG y points down.
+  // Fails if the file cannot be read, if any path or points data is malformed,
+  // naming the first bad element and the offset into its data, or if no loops
+  // were found.
+  COMMON_API bool ImportSvg(char const *path, float tolerance, bool flipVertical,
+                            std::vector<xn::PolygonLoop> *pLoops, std::string *pError);
+}
+
+#endif
\ No newline at end of file
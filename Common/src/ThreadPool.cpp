@@ -0,0 +1,513 @@
+
+#include <stdio.h>
+#include <atomic>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include <condition_variable>
+
+#include "ThreadPool.h"
+#include "Trace.h"
+
+namespace Common
+{
+  // Set while a thread is running tasks, so nested calls can run serially.
+  static thread_local uint32_t t_currentSlot = 0xFFFFFFFF;
+
+  class ThreadPool::PIMPL
+  {
+    struct Range
+    {
+      size_t begin;
+      size_t end;
+    };
+
+    struct Queue
+    {
+      std::mutex mutex;
+      std::deque<Range> ranges;
+    };
+
+  public:
+
+    PIMPL(uint32_t threadCount);
+    ~PIMPL();
+
+    uint32_t ThreadCount() const { return (uint32_t)m_queues.size(); }
+    bool ParallelFor(size_t count, Task const &task, char const *category, CancelToken const *pCancel);
+    void GetStats(std::vector<PoolStats> *pStats) const;
+    void ResetStats();
+
+  private:
+
+    void WorkerMain(uint32_t slot);
+    void RunTasks(uint32_t slot, Task const &task);
+    void AddStats(char const *category, size_t tasks, uint64_t busyNs, uint64_t wallNs);
+    void Push(uint32_t slot, Range const &range);
+    bool Pop(uint32_t slot, Range *pRange);
+    bool Steal(uint32_t slot, Range *pRange);
+    void WaitForRanges();
+
+  private:
+
+    std::vector<std::thread> m_threads;
+    std::vector<Queue> m_queues;
+
+    std::mutex m_submitMutex;
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_done;
+
+    // Threads with nothing to pop or steal park here until a range is queued or
+    // the job ends, rather than spinning.
+    std::mutex m_idleMutex;
+    std::condition_variable m_idle;
+    std::atomic<size_t> m_queuedRanges;
+    std::atomic<uint32_t> m_idleWorkers;
+
+    Task const *m_pTask;
+    char const *m_category;
+    CancelToken const *m_pCancel;
+    std::atomic<bool> m_cancelled;
+    std::atomic<bool> m_failed;
+    std::exception_ptr m_exception;   // First one thrown by a task, guarded by m_mutex
+    std::atomic<uint64_t> m_busyNs;
+    size_t m_grain;
+    uint64_t m_generation;
+    std::atomic<size_t> m_remaining;
+    uint32_t m_busyWorkers;
+    bool m_quit;
+
+    mutable std::mutex m_statsMutex;
+    std::vector<PoolStats> m_stats;
+  };
+
+  ThreadPool::PIMPL::PIMPL(uint32_t threadCount)
+    : m_threads()
+    , m_queues(threadCount == 0 ? std::max(1u, std::thread::hardware_concurrency()) : threadCount)
+    , m_queuedRanges(0)
+    , m_idleWorkers(0)
+    , m_pTask(nullptr)
+    , m_category(nullptr)
+    , m_pCancel(nullptr)
+    , m_cancelled(false)
+    , m_failed(false)
+    , m_exception()
+    , m_busyNs(0)
+    , m_grain(1)
+    , m_generation(0)
+    , m_remaining(0)
+    , m_busyWorkers(0)
+    , m_quit(false)
+  {
+    for (uint32_t slot = 1; slot < (uint32_t)m_queues.size(); slot++)
+      m_threads.push_back(std::thread(&PIMPL::WorkerMain, this, slot));
+  }
+
+  ThreadPool::PIMPL::~PIMPL()
+  {
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_quit = true;
+    }
+    m_wake.notify_all();
+
+    for (auto &thread : m_threads)
+      thread.join();
+  }
+
+  void ThreadPool::PIMPL::WorkerMain(uint32_t slot)
+  {
+    uint64_t generation = 0;
+    for (;;)
+    {
+      Task const *pTask = nullptr;
+      {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_wake.wait(lock, [&]() { return m_quit || m_generation != generation; });
+        if (m_quit)
+          return;
+        generation = m_generation;
+
+        // Woken after the job already finished.
+        if (m_pTask == nullptr)
+          continue;
+
+        pTask = m_pTask;
+        m_busyWorkers++;
+      }
+
+      RunTasks(slot, *pTask);
+
+      {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_busyWorkers--;
+      }
+      m_done.notify_all();
+    }
+  }
+
+  void ThreadPool::PIMPL::Push(uint32_t slot, Range const &range)
+  {
+    {
+      Queue &queue = m_queues[slot];
+      std::lock_guard<std::mutex> lock(queue.mutex);
+      queue.ranges.push_back(range);
+    }
+
+    // Pairs with WaitForRanges, which counts itself idle before it checks the
+    // queued count, so either it sees this range or this sees it waiting.
+    m_queuedRanges++;
+    if (m_idleWorkers.load() > 0)
+    {
+      std::lock_guard<std::mutex> lock(m_idleMutex);
+      m_idle.notify_one();
+    }
+  }
+
+  bool ThreadPool::PIMPL::Pop(uint32_t slot, Range *pRange)
+  {
+    Queue &queue = m_queues[slot];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.ranges.empty())
+      return false;
+    *pRange = queue.ranges.back();
+    queue.ranges.pop_back();
+    m_queuedRanges--;
+    return true;
+  }
+
+  bool ThreadPool::PIMPL::Steal(uint32_t slot, Range *pRange)
+  {
+    for (uint32_t i = 1; i < (uint32_t)m_queues.size(); i++)
+    {
+      Queue &queue = m_queues[(slot + i) % m_queues.size()];
+      std::lock_guard<std::mutex> lock(queue.mutex);
+      if (queue.ranges.empty())
+        continue;
+      *pRange = queue.ranges.front();
+      queue.ranges.pop_front();
+      m_queuedRanges--;
+      return true;
+    }
+    return false;
+  }
+
+  void ThreadPool::PIMPL::WaitForRanges()
+  {
+    std::unique_lock<std::mutex> lock(m_idleMutex);
+    m_idleWorkers++;
+    m_idle.wait(lock, [&]() { return m_queuedRanges.load() > 0 || m_remaining.load() == 0; });
+    m_idleWorkers--;
+  }
+
+  void ThreadPool::PIMPL::RunTasks(uint32_t slot, Task const &task)
+  {
+    t_currentSlot = slot;
+
+    while (m_remaining.load() > 0)
+    {
+      Range range;
+      if (!Pop(slot, &range) && !Steal(slot, &range))
+      {
+        // Every queued range is being run by another thread; only a split of one
+        // of them, or the end of the job, gives this thread anything to do.
+        if (m_queuedRanges.load() == 0)
+          WaitForRanges();
+        continue;
+      }
+
+      // Keep the front half and leave the rest where other threads can steal it.
+      while (range.end - range.begin > m_grain)
+      {
+        size_t mid = range.begin + (range.end - range.begin) / 2;
+        Push(slot, Range{mid, range.end});
+        range.end = mid;
+      }
+
+      // Tasks are timed per range, which keeps the clock reads off the per-index path.
+      uint64_t start = TraceTime();
+      for (size_t i = range.begin; i < range.end && !m_failed; i++)
+      {
+        if (m_pCancel != nullptr && m_pCancel->IsCancelled())
+        {
+          m_cancelled = true;
+          break;
+        }
+
+        // An exception must not reach the worker's entry point, which would
+        // terminate the process. Keep the first, skip the remaining tasks and
+        // rethrow it on the calling thread.
+        try
+        {
+          task(i, slot);
+        }
+        catch (...)
+        {
+          std::lock_guard<std::mutex> lock(m_mutex);
+          if (!m_failed)
+            m_exception = std::current_exception();
+          m_failed = true;
+        }
+      }
+      uint64_t end = TraceTime();
+      m_busyNs += end - start;
+#ifndef XN_NO_TRACE
+      if (IsTracing())
+        RecordTrace(m_category, "Tasks", start, end);
+#endif
+      if (m_remaining.fetch_sub(range.end - range.begin) == range.end - range.begin)
+      {
+        std::lock_guard<std::mutex> lock(m_idleMutex);
+        m_idle.notify_all();
+      }
+    }
+
+    t_currentSlot = 0xFFFFFFFF;
+  }
+
+  bool ThreadPool::PIMPL::ParallelFor(size_t count, Task const &task, char const *category, CancelToken const *pCancel)
+  {
+    if (count == 0)
+      return true;
+
+    if (t_currentSlot != 0xFFFFFFFF || m_queues.size() == 1 || count == 1)
+    {
+      // Nested runs are not counted; their time already belongs to the enclosing job.
+      uint32_t previous = t_currentSlot;
+      uint32_t slot = previous == 0xFFFFFFFF ? 0 : previous;
+      uint64_t start = TraceTime();
+      t_currentSlot = slot;
+      bool completed = true;
+      try
+      {
+        for (size_t i = 0; i < count && completed; i++)
+        {
+          completed = pCancel == nullptr || !pCancel->IsCancelled();
+          if (completed)
+            task(i, slot);
+        }
+      }
+      catch (...)
+      {
+        t_currentSlot = previous;
+        throw;
+      }
+      t_currentSlot = previous;
+
+      if (previous == 0xFFFFFFFF)
+      {
+        uint64_t end = TraceTime();
+#ifndef XN_NO_TRACE
+        if (IsTracing())
+          RecordTrace(category, "Tasks", start, end);
+#endif
+        AddStats(category, count, end - start, end - start);
+      }
+      return completed;
+    }
+
+    std::lock_guard<std::mutex> submitLock(m_submitMutex);
+    uint64_t submitted = TraceTime();
+
+    // Seed every queue with an equal share; stealing evens out the rest. No worker
+    // is running tasks yet, so the queues are filled without waking anyone.
+    size_t threads = m_queues.size();
+    size_t share = (count + threads - 1) / threads;
+    for (size_t t = 0; t < threads; t++)
+    {
+      size_t begin = t * share;
+      size_t end = std::min(count, begin + share);
+      if (begin >= end)
+        break;
+
+      std::lock_guard<std::mutex> lock(m_queues[t].mutex);
+      m_queues[t].ranges.push_back(Range{begin, end});
+      m_queuedRanges++;
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_pTask = &task;
+      m_category = category;
+      m_pCancel = pCancel;
+      m_cancelled = false;
+      m_failed = false;
+      m_exception = nullptr;
+      m_busyNs = 0;
+      m_grain = std::max<size_t>(1, count / (threads * 16));
+      m_remaining = count;
+      m_generation++;
+    }
+    m_wake.notify_all();
+
+    RunTasks(0, task);
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_done.wait(lock, [&]() { return m_busyWorkers == 0; });
+    m_pTask = nullptr;
+    m_pCancel = nullptr;
+    std::exception_ptr exception = m_exception;
+    m_exception = nullptr;
+    lock.unlock();
+
+    AddStats(category, count, m_busyNs, TraceTime() - submitted);
+    if (exception != nullptr)
+      std::rethrow_exception(exception);
+    return !m_cancelled;
+  }
+
+  void ThreadPool::PIMPL::AddStats(char const *category, size_t tasks, uint64_t busyNs, uint64_t wallNs)
+  {
+    std::lock_guard<std::mutex> lock(m_statsMutex);
+    PoolStats *pStats = nullptr;
+    for (auto &stats : m_stats)
+    {
+      if (stats.category == category)
+        pStats = &stats;
+    }
+    if (pStats == nullptr)
+    {
+      m_stats.push_back(PoolStats{category, 0, 0, 0.f, 0.f});
+      pStats = &m_stats.back();
+    }
+
+    pStats->jobs++;
+    pStats->tasks += tasks;
+    pStats->busyMs += (float)busyNs * 1.e-6f;
+    pStats->wallMs += (float)wallNs * 1.e-6f;
+  }
+
+  void ThreadPool::PIMPL::GetStats(std::vector<PoolStats> *pStats) const
+  {
+    std::lock_guard<std::mutex> lock(m_statsMutex);
+    *pStats = m_stats;
+  }
+
+  void ThreadPool::PIMPL::ResetStats()
+  {
+    std::lock_guard<std::mutex> lock(m_statsMutex);
+    m_stats.clear();
+  }
+
+  //----------------------------------------------------------------
+  // ThreadPool
+  //----------------------------------------------------------------
+
+  ThreadPool::ThreadPool(uint32_t threadCount)
+    : m_pimpl(new PIMPL(threadCount))
+  {
+
+  }
+
+  ThreadPool::~ThreadPool()
+  {
+    delete m_pimpl;
+  }
+
+  ThreadPool &ThreadPool::Shared()
+  {
+    // Never destroyed. Joining threads while the library unloads can deadlock, and
+    // the process is exiting anyway.
+    static ThreadPool *s_pPool = new ThreadPool();
+    return *s_pPool;
+  }
+
+  uint32_t ThreadPool::ThreadCount() const
+  {
+    return m_pimpl->ThreadCount();
+  }
+
+  bool ThreadPool::ParallelFor(size_t count, Task const &task, char const *category, CancelToken const *pCancel)
+  {
+    return m_pimpl->ParallelFor(count, task, category, pCancel);
+  }
+
+  void ThreadPool::GetStats(std::vector<PoolStats> *pStats) const
+  {
+    m_pimpl->GetStats(pStats);
+  }
+
+  void ThreadPool::ResetStats()
+  {
+    m_pimpl->ResetStats();
+  }
+
+  //----------------------------------------------------------------
+  // TaskGroup
+  //----------------------------------------------------------------
+
+  class TaskGroup::PIMPL
+  {
+  public:
+
+    PIMPL(ThreadPool &pool, char const *category, CancelToken const *pCancel)
+      : pool(pool)
+      , category(category)
+      , pCancel(pCancel)
+      , completed(true)
+    {
+
+    }
+
+    void RunPending()
+    {
+      // Taken out first, so tasks are not run again if one of them throws.
+      std::vector<Fn> tasks;
+      tasks.swap(pending);
+      completed = pool.ParallelFor(tasks.size(), [&tasks](size_t i, uint32_t)
+      {
+        tasks[i]();
+      }, category, pCancel) && completed;
+    }
+
+    ThreadPool &pool;
+    char const *category;
+    CancelToken const *pCancel;
+    std::vector<Fn> pending;
+    bool completed;
+  };
+
+  TaskGroup::TaskGroup(ThreadPool &pool, char const *category, CancelToken const *pCancel)
+    : m_pimpl(new PIMPL(pool, category, pCancel))
+  {
+
+  }
+
+  TaskGroup::~TaskGroup()
+  {
+    // Throwing from a destructor would terminate the process. A group that is
+    // waited on explicitly reports the exception from Wait instead.
+    try
+    {
+      Wait();
+    }
+    catch (std::exception const &e)
+    {
+      fprintf(stderr, "Task in group '%s' failed: %s\n", m_pimpl->category, e.what());
+    }
+    catch (...)
+    {
+      fprintf(stderr, "Task in group '%s' failed\n", m_pimpl->category);
+    }
+    delete m_pimpl;
+  }
+
+  void TaskGroup::Run(Fn const &fn)
+  {
+    if (m_pimpl->pending.size() == MaxPending)
+      m_pimpl->RunPending();
+    m_pimpl->pending.push_back(fn);
+  }
+
+  bool TaskGroup::Wait()
+  {
+    m_pimpl->RunPending();
+    bool completed = m_pimpl->completed;
+    m_pimpl->completed = true;
+    return completed;
+  }
+}
\ No newline at end of file
@@ -0,0 +1,126 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <stdint.h>
+#include <atomic>
+#include <string>
+#include <vector>
+#include <functional>
+
+#include "CommonAPI.h"
+
+namespace Common
+{
+  // Set from any thread to stop a job early. Tasks already running finish; the
+  // ones not yet started are skipped.
+  class CancelToken
+  {
+  public:
+
+    CancelToken()
+      : m_cancelled(false)
+    {
+
+    }
+
+    void Cancel() { m_cancelled.store(true, std::memory_order_relaxed); }
+    void Reset() { m_cancelled.store(false, std::memory_order_relaxed); }
+    bool IsCancelled() const { return m_cancelled.load(std::memory_order_relaxed); }
+
+  private:
+
+    std::atomic<bool> m_cancelled;
+  };
+
+  // Totals for the jobs submitted under one category.
+  struct PoolStats
+  {
+    std::string category;
+    uint64_t jobs;
+    uint64_t tasks;
+    float busyMs;   // Summed over all threads
+    float wallMs;   // From submit to completion
+  };
+
+  // Work-stealing thread pool. Each thread owns a queue of index ranges; it splits
+  // the range it is working on and leaves the other half in its queue, where idle
+  // threads can steal it. A range is only split while it is larger than the grain,
+  // so a queue never holds more than log2(count) ranges. The calling thread takes
+  // part as thread 0. A thread that finds nothing to pop or steal sleeps until
+  // another thread queues a range or the job ends.
+  //
+  // Modules should use Shared() rather than a pool of their own, so the process
+  // never runs more threads than there are cores.
+  class COMMON_API ThreadPool
+  {
+  public:
+
+    typedef std::function<void(size_t index, uint32_t thread)> Task;
+
+    // A thread count of 0 uses one thread per hardware thread.
+    explicit ThreadPool(uint32_t threadCount = 0);
+    ~ThreadPool();
+
+    ThreadPool(ThreadPool const &) = delete;
+    ThreadPool &operator=(ThreadPool const &) = delete;
+
+    // The process-wide pool, one thread per hardware thread. Common is a shared
+    // library, so every module in the process gets the same one.
+    static ThreadPool &Shared();
+
+    // Threads that may run tasks, including the caller. Use this to size
+    // per-thread result buffers, indexed by the thread argument of the task.
+    uint32_t ThreadCount() const;
+
+    // Calls task(i, thread) for every i in [0, count) and returns when all are done.
+    // Calls from inside a task run serially on the calling thread, and calls from
+    // other threads wait for the running job. The category labels the job in the
+    // statistics and in traces, which keep copies of it. Returns false if pCancel was set
+    // before every task had started. If a task throws, the tasks not yet started
+    // are skipped and the first exception is rethrown here once the others finish.
+    bool ParallelFor(size_t count, Task const &task, char const *category = "Other", CancelToken const *pCancel = nullptr);
+
+    // Totals per category since the last reset.
+    void GetStats(std::vector<PoolStats> *pStats) const;
+    void ResetStats();
+
+  private:
+
+    class PIMPL;
+    PIMPL *m_pimpl;
+  };
+
+  // Independent tasks run together on a pool. Tasks are queued by Run and start
+  // when Wait is called. At most MaxPending tasks are queued; Run starts the queued
+  // tasks itself when the queue is full, so a producer cannot run ahead unbounded.
+  class COMMON_API TaskGroup
+  {
+  public:
+
+    typedef std::function<void()> Fn;
+
+    static size_t const MaxPending = 1024;
+
+    TaskGroup(ThreadPool &pool, char const *category, CancelToken const *pCancel = nullptr);
+
+    // Waits for any queued tasks. An exception from one of them is written to
+    // stderr rather than thrown; call Wait first to handle it.
+    ~TaskGroup();
+
+    TaskGroup(TaskGroup const &) = delete;
+    TaskGroup &operator=(TaskGroup const &) = delete;
+
+    void Run(Fn const &fn);
+
+    // Runs the queued tasks and returns when they are done. Returns false if the
+    // group was cancelled before every task had started.
+    bool Wait();
+
+  private:
+
+    class PIMPL;
+    PIMPL *m_pimpl;
+  };
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,177 @@
+#include <stdio.h>
+#include <string.h>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <unordered_set>
+
+#include "Trace.h"
+
+namespace Common
+{
+  namespace
+  {
+    struct TraceEvent
+    {
+      char const *category;
+      char const *name;
+      uint64_t start;
+      uint64_t end;
+    };
+
+    uint32_t const NameCacheSize = 32;
+
+    struct NameCacheEntry
+    {
+      char const *pKey;
+      char const *pName;
+    };
+
+    // Written only by its own thread. The count is published after each event,
+    // so the writer never waits for a reader.
+    struct ThreadBuffer
+    {
+      uint32_t threadIndex;
+      std::atomic<uint64_t> count;
+      NameCacheEntry names[NameCacheSize];
+      TraceEvent events[TraceBufferSize];
+    };
+
+    std::atomic<bool> s_tracing(false);
+
+    // Copies of every name and category recorded, kept until exit, so events never
+    // point into a module that has been unloaded since.
+    std::mutex s_namesMutex;
+    std::unordered_set<std::string> s_names;
+
+    // Buffers outlive their threads, so events from finished worker threads can
+    // still be written out. They are freed at exit.
+    std::mutex s_buffersMutex;
+    std::vector<ThreadBuffer *> s_buffers;
+
+    struct BufferCleanup
+    {
+      ~BufferCleanup()
+      {
+        for (ThreadBuffer *pBuffer : s_buffers)
+          delete pBuffer;
+      }
+    } s_bufferCleanup;
+
+    thread_local ThreadBuffer *t_buffer = nullptr;
+
+    ThreadBuffer *GetThreadBuffer()
+    {
+      if (t_buffer == nullptr)
+      {
+        ThreadBuffer *pBuffer = new ThreadBuffer();
+        pBuffer->count = 0;
+
+        std::lock_guard<std::mutex> lock(s_buffersMutex);
+        pBuffer->threadIndex = (uint32_t)s_buffers.size();
+        s_buffers.push_back(pBuffer);
+        t_buffer = pBuffer;
+      }
+      return t_buffer;
+    }
+
+    // Returns the stored copy of the text. Each thread remembers the copies of the
+    // strings it records most, so the shared set is only searched on a miss. The text
+    // is compared as well as the pointer, as another string may later be loaded at
+    // the same address.
+    char const *InternName(ThreadBuffer *pBuffer, char const *pText)
+    {
+      NameCacheEntry &entry = pBuffer->names[((uintptr_t)pText >> 3) % NameCacheSize];
+      if (entry.pKey == pText && strcmp(entry.pName, pText) == 0)
+        return entry.pName;
+
+      std::lock_guard<std::mutex> lock(s_namesMutex);
+      entry.pKey = pText;
+      entry.pName = s_names.insert(pText).first->c_str();
+      return entry.pName;
+    }
+
+    void WriteEscaped(FILE *pFile, char const *pText)
+    {
+      for (; *pText != '\0'; pText++)
+      {
+        if (*pText == '"' || *pText == '\\')
+          fputc('\\', pFile);
+        if ((unsigned char)*pText >= 0x20)
+          fputc(*pText, pFile);
+      }
+    }
+  }
+
+  void SetTracing(bool enabled)
+  {
+    s_tracing.store(enabled, std::memory_order_relaxed);
+  }
+
+  bool IsTracing()
+  {
+    return s_tracing.load(std::memory_order_relaxed);
+  }
+
+  uint64_t TraceTime()
+  {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+  }
+
+  void RecordTrace(char const *category, char const *name, uint64_t start, uint64_t end)
+  {
+    ThreadBuffer *pBuffer = GetThreadBuffer();
+    uint64_t count = pBuffer->count.load(std::memory_order_relaxed);
+    pBuffer->events[count % TraceBufferSize] = TraceEvent{InternName(pBuffer, category), InternName(pBuffer, name), start, end};
+    pBuffer->count.store(count + 1, std::memory_order_release);
+  }
+
+  void ClearTrace()
+  {
+    std::lock_guard<std::mutex> lock(s_buffersMutex);
+    for (ThreadBuffer *pBuffer : s_buffers)
+      pBuffer->count.store(0, std::memory_order_relaxed);
+  }
+
+  bool WriteChromeTrace(char const *path)
+  {
+    FILE *pFile = fopen(path, "wb");
+    if (pFile == nullptr)
+      return false;
+
+    std::lock_guard<std::mutex> lock(s_buffersMutex);
+
+    // Timestamps are written relative to the first event, in microseconds.
+    uint64_t origin = UINT64_MAX;
+    for (ThreadBuffer const *pBuffer : s_buffers)
+    {
+      uint64_t count = pBuffer->count.load(std::memory_order_acquire);
+      for (uint64_t i = count - std::min<uint64_t>(count, TraceBufferSize); i < count; i++)
+        origin = std::min(origin, pBuffer->events[i % TraceBufferSize].start);
+    }
+
+    fprintf(pFile, "{\"traceEvents\":[\n");
+    bool first = true;
+    for (ThreadBuffer const *pBuffer : s_buffers)
+    {
+      uint64_t count = pBuffer->count.load(std::memory_order_acquire);
+      for (uint64_t i = count - std::min<uint64_t>(count, TraceBufferSize); i < count; i++)
+      {
+        TraceEvent const &event = pBuffer->events[i % TraceBufferSize];
+        fprintf(pFile, first ? "{\"name\":\"" : ",\n{\"name\":\"");
+        WriteEscaped(pFile, event.name);
+        fprintf(pFile, "\",\"cat\":\"");
+        WriteEscaped(pFile, event.category);
+        fprintf(pFile, "\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%u}",
+                (double)(event.start - origin) * 1.e-3, (double)(event.end - event.start) * 1.e-3, pBuffer->threadIndex);
+        first = false;
+      }
+    }
+    fprintf(pFile, "\n]}\n");
+
+    return fclose(pFile) == 0;
+  }
+}
\ No newline at end of file
@@ -0,0 +1,192 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+
+#include "CommonAPI.h"
+
+// Scoped timing spans, recorded per thread into a ring buffer while tracing is on,
+// and written out in the Chrome trace_event format (load it in chrome://tracing or
+// Perfetto). Names and categories are copied, so they may come from a module that
+// is unloaded before the trace is written. When tracing is off a span costs one
+// flag test. Define XN_NO_TRACE to compile the spans out altogether.
+//
+//   XN_TRACE_SCOPE("Shadowing", "SetRegion");
+//
+// Module entry points use XN_TRACE_MODULE_SCOPE, which also adds the time to the
+// module's FrameTimes, whether or not tracing is on.
+namespace Common
+{
+  // Events kept per thread. Older events are overwritten.
+  uint32_t const TraceBufferSize = 1 << 16;
+
+  COMMON_API void SetTracing(bool enabled);
+  COMMON_API bool IsTracing();
+
+  // Nanoseconds on a steady clock.
+  COMMON_API uint64_t TraceTime();
+
+  // Records a span from two TraceTime() readings on the calling thread.
+  COMMON_API void RecordTrace(char const *category, char const *name, uint64_t start, uint64_t end);
+
+  // Drops all recorded events. Call with tracing off.
+  COMMON_API void ClearTrace();
+
+  // Writes the recorded events of every thread as trace_event JSON. Call with
+  // tracing off; spans still being written by other threads may be cut short.
+  COMMON_API bool WriteChromeTrace(char const *path);
+
+  class TraceScope
+  {
+  public:
+
+    TraceScope(char const *category, char const *name)
+      : m_category(category)
+      , m_name(name)
+      , m_start(IsTracing() ? TraceTime() : 0)
+    {
+
+    }
+
+    ~TraceScope()
+    {
+      if (m_start != 0)
+        RecordTrace(m_category, m_name, m_start, TraceTime());
+    }
+
+    TraceScope(TraceScope const &) = delete;
+    TraceScope &operator=(TraceScope const &) = delete;
+
+  private:
+
+    char const *m_category;
+    char const *m_name;
+    uint64_t m_start;
+  };
+
+  // Rolling per-frame totals for one module. Time from nested entry points, eg
+  // SetGeometry called from _DoFrame, is only counted once.
+  class FrameTimes
+  {
+  public:
+
+    static int const s_historySize = 120;
+
+    class Scope
+    {
+    public:
+
+      explicit Scope(FrameTimes *pFrameTimes)
+        : m_pFrameTimes(pFrameTimes)
+      {
+        m_pFrameTimes->Begin();
+      }
+
+      ~Scope()
+      {
+        m_pFrameTimes->End();
+      }
+
+      Scope(Scope const &) = delete;
+      Scope &operator=(Scope const &) = delete;
+
+    private:
+
+      FrameTimes *m_pFrameTimes;
+    };
+
+    FrameTimes()
+      : m_frames{}
+      , m_index(0)
+      , m_count(0)
+      , m_current(0)
+      , m_start(0)
+      , m_depth(0)
+    {
+
+    }
+
+    void Begin()
+    {
+      if (m_depth++ == 0)
+        m_start = TraceTime();
+    }
+
+    void End()
+    {
+      if (--m_depth == 0)
+        m_current += TraceTime() - m_start;
+    }
+
+    // Closes the current frame. Modules call this once per frame, from _DoFrame.
+    void EndFrame()
+    {
+      m_frames[m_index] = (float)m_current * 1.e-6f;
+      m_index = (m_index + 1) % s_historySize;
+      if (m_count < s_historySize)
+        m_count++;
+      m_current = 0;
+    }
+
+    // Milliseconds of the last closed frame.
+    float LastMs() const
+    {
+      return m_count == 0 ? 0.f : m_frames[(m_index + s_historySize - 1) % s_historySize];
+    }
+
+    float AverageMs() const
+    {
+      float sum = 0.f;
+      for (int i = 0; i < m_count; i++)
+        sum += m_frames[i];
+      return m_count == 0 ? 0.f : sum / (float)m_count;
+    }
+
+    float MaxMs() const
+    {
+      float result = 0.f;
+      for (int i = 0; i < m_count; i++)
+        result = m_frames[i] > result ? m_frames[i] : result;
+      return result;
+    }
+
+  private:
+
+    float m_frames[s_historySize];
+    int m_index;
+    int m_count;
+    uint64_t m_current;
+    uint64_t m_start;
+    int m_depth;
+  };
+
+  class ModuleTraceScope
+  {
+  public:
+
+    ModuleTraceScope(FrameTimes *pFrameTimes, char const *category, char const *name)
+      : m_frameScope(pFrameTimes)
+      , m_traceScope(category, name)
+    {
+
+    }
+
+  private:
+
+    FrameTimes::Scope m_frameScope;
+    TraceScope m_traceScope;
+  };
+}
+
+#define XN_TRACE_CONCAT_INNER(a, b) a##b
+#define XN_TRACE_CONCAT(a, b) XN_TRACE_CONCAT_INNER(a, b)
+
+#ifdef XN_NO_TRACE
+  #define XN_TRACE_SCOPE(category, name)
+  #define XN_TRACE_MODULE_SCOPE(frameTimes, category, name) Common::FrameTimes::Scope XN_TRACE_CONCAT(xnTrace, __LINE__)(&(frameTimes))
+#else
+  #define XN_TRACE_SCOPE(category, name) Common::TraceScope XN_TRACE_CONCAT(xnTrace, __LINE__)(category, name)
+  #define XN_TRACE_MODULE_SCOPE(frameTimes, category, name) Common::ModuleTraceScope XN_TRACE_CONCAT(xnTrace, __LINE__)(&(frameTimes), category, name)
+#endif
+
+#endif
\ No newline at end of file
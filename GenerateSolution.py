@@ -2,7 +2,7 @@ import subprocess
 import sys
 import os
 
-sys.path.insert(0, 'DgLib\\3rdParty\\BuildScripts')
+sys.path.insert(0, os.path.join('DgLib', '3rdParty', 'BuildScripts'))
 
 import DgBuild
 
@@ -38,4 +38,7 @@ CreatePluginDirs("Samples")
 CreatePluginDirs("XornPlugins")
 
 DgBuild.Make_vpaths("DgLib/src/", "DgLib/DgLib_vpaths.lua")
-subprocess.call("DgLib/3rdParty/premake/premake5.exe vs2022")
+if sys.platform == 'win32':
+    subprocess.call("DgLib/3rdParty/premake/premake5.exe vs2022")
+else:
+    subprocess.call(["premake5", "gmake2"])
@@ -0,0 +1,71 @@
+
+#include "Geometry.h"
+#include "ObjFile.h"
+#include "LoopFile.h"
+#include "SvgImport.h"
+
+using namespace xn;
+
+static bool EndsWith(std::string const &str, char const *suffix)
+{
+  std::string s(suffix);
+  return str.size() >= s.size() && str.compare(str.size() - s.size(), s.size(), s) == 0;
+}
+
+static bool ReadLoopFile(std::string const &path, std::vector<PolygonLoop> *pLoops, std::string *pError)
+{
+  Common::LoopFile file;
+  if (!file.Open(path.c_str()))
+  {
+    *pError = "Unable to open '" + path + "' as a loop file";
+    return false;
+  }
+
+  pLoops->clear();
+  pLoops->resize(file.LoopCount());
+  for (size_t i = 0; i < file.LoopCount(); i++)
+  {
+    float const *pPoints = file.LoopPoints(i);
+    size_t size = file.LoopSize(i);
+    for (size_t v = 0; v < size; v++)
+      (*pLoops)[i].PushBack(vec2(pPoints[2 * v], pPoints[2 * v + 1]));
+  }
+  return true;
+}
+
+bool LoadGeometry(std::string const &path, float tolerance, std::vector<PolygonLoop> *pLoops, std::string *pError)
+{
+  if (EndsWith(path, ".xnl"))
+    return ReadLoopFile(path, pLoops, pError);
+  if (EndsWith(path, ".svg"))
+    return Common::ImportSvg(path.c_str(), tolerance, true, pLoops, pError);
+  return ReadObj(path, pLoops, pError);
+}
+
+bool ConvertToLoopFile(std::string const &inPath, std::string const &outPath, float tolerance, std::string *pError)
+{
+  std::vector<PolygonLoop> loops;
+  if (!LoadGeometry(inPath, tolerance, &loops, pError))
+    return false;
+
+  std::vector<float> points;
+  std::vector<uint64_t> offsets;
+  offsets.push_back(0);
+  for (auto const &loop : loops)
+  {
+    for (auto it = loop.cPointsBegin(); it != loop.cPointsEnd(); it++)
+    {
+      vec2 p = *it;
+      points.push_back(p.x());
+      points.push_back(p.y());
+    }
+    offsets.push_back(points.size() / 2);
+  }
+
+  if (!Common::WriteLoopFile(outPath.c_str(), points.data(), offsets.data(), loops.size()))
+  {
+    *pError = "Unable to write '" + outPath + "'";
+    return false;
+  }
+  return true;
+}
\ No newline at end of file
@@ -0,0 +1,17 @@
+#ifndef GEOMETRY_H
+#define GEOMETRY_H
+
+#include <string>
+#include <vector>
+
+#include "xnGeometry.h"
+
+// Loads an OBJ file, a binary loop file (see Common/LoopFile.h) if the path ends
+// in '.xnl', or an SVG file if it ends in '.svg'. SVG curves are flattened to
+// within 'tolerance'.
+bool LoadGeometry(std::string const &path, float tolerance, std::vector<xn::PolygonLoop> *pLoops, std::string *pError);
+
+// Writes the loops of an OBJ or SVG file to a binary loop file.
+bool ConvertToLoopFile(std::string const &inPath, std::string const &outPath, float tolerance, std::string *pError);
+
+#endif
\ No newline at end of file
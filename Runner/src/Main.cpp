@@ -0,0 +1,262 @@
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include "Modules.h"
+#include "Geometry.h"
+#include "Replay.h"
+#include "Trace.h"
+#include "ThreadPool.h"
+#include "ResultCache.h"
+
+using namespace xn;
+
+typedef std::chrono::high_resolution_clock Clock;
+
+static void PrintUsage()
+{
+  printf("Usage: Runner <module> <geometry> [--repeat N] [--tolerance T] [--simplify T]\n");
+  printf("              [--trace out.json] [--cache MB] [name=value ...]\n");
+  printf("       Runner convert <input> <output.xnl> [--tolerance T]\n");
+  printf("       Runner replay <input.xnr> [--trace out.json] [--cache MB]\n\n");
+  printf("Runs the module's SetGeometry on the geometry, then any queries, and prints\n");
+  printf("timings and result statistics. Geometry is an OBJ file, a binary loop file\n");
+  printf("if it ends in '.xnl', or an SVG file if it ends in '.svg'. SVG curves are\n");
+  printf("flattened to within the tolerance, 0.1 by default. The convert command\n");
+  printf("writes a binary loop file from an OBJ or SVG file. --simplify sets the\n");
+  printf("tolerance of the module's input simplification, 0 by default. --trace\n");
+  printf("writes the traced spans as Chrome trace_event JSON. --cache limits the\n");
+  printf("result cache, 256 MB by default; 0 turns it off. The replay command\n");
+  printf("feeds an input recording, saved from a module's panel, back to the module\n");
+  printf("and prints the time taken per event and per frame. It runs with the cache\n");
+  printf("off unless --cache is given, so every event is timed cold.\n\n");
+  printf("Modules and their parameters:\n");
+  for (auto const &runner : GetModuleRunners())
+    printf("  %-18s %s\n", runner.name, runner.usage);
+}
+
+int main(int argc, char **argv)
+{
+  if (argc < 3)
+  {
+    PrintUsage();
+    return 1;
+  }
+
+  float tolerance = 0.1f;
+  if (std::string(argv[1]) == "convert")
+  {
+    if (argc == 6 && std::string(argv[4]) == "--tolerance")
+      tolerance = (float)atof(argv[5]);
+    else if (argc != 4)
+    {
+      fprintf(stderr, "Expected: Runner convert <input> <output.xnl> [--tolerance T]\n");
+      return 1;
+    }
+
+    std::string error;
+    if (!ConvertToLoopFile(argv[2], argv[3], tolerance, &error))
+    {
+      fprintf(stderr, "%s\n", error.c_str());
+      return 1;
+    }
+    return 0;
+  }
+
+  if (std::string(argv[1]) == "replay")
+  {
+    // Results of earlier events would otherwise be read back from the cache, and
+    // the replay would time cache lookups rather than the work being recorded.
+    std::string tracePath;
+    size_t cacheLimit = 0;
+    for (int i = 3; i < argc; i++)
+    {
+      std::string arg = argv[i];
+      if (arg == "--trace" && i + 1 < argc)
+        tracePath = argv[++i];
+      else if (arg == "--cache" && i + 1 < argc)
+        cacheLimit = (size_t)(std::max(0.0, atof(argv[++i])) * 1024.0 * 1024.0);
+      else
+      {
+        fprintf(stderr, "Expected: Runner replay <input.xnr> [--trace out.json] [--cache MB]\n");
+        return 1;
+      }
+    }
+
+    Common::SetTracing(!tracePath.empty());
+    Common::ResultCache::Shared().SetByteLimit(cacheLimit);
+    std::string error;
+    if (!ReplayRecording(argv[2], &error))
+    {
+      fprintf(stderr, "%s\n", error.c_str());
+      return 1;
+    }
+
+    if (!tracePath.empty())
+    {
+      Common::SetTracing(false);
+      if (!Common::WriteChromeTrace(tracePath.c_str()))
+        fprintf(stderr, "Could not write %s\n", tracePath.c_str());
+    }
+    return 0;
+  }
+
+  ModuleRunner const *pRunner = FindModuleRunner(argv[1]);
+  if (pRunner == nullptr)
+  {
+    fprintf(stderr, "Unknown module '%s'\n\n", argv[1]);
+    PrintUsage();
+    return 1;
+  }
+
+  std::string path = argv[2];
+  int repeat = 1;
+  float simplify = 0.f;
+  std::string tracePath;
+  size_t cacheLimit = Common::ResultCache::DefaultByteLimit;
+  Parameters params;
+  for (int i = 3; i < argc; i++)
+  {
+    std::string arg = argv[i];
+    if (arg == "--repeat" && i + 1 < argc)
+    {
+      repeat = std::max(1, atoi(argv[++i]));
+      continue;
+    }
+    if (arg == "--tolerance" && i + 1 < argc)
+    {
+      tolerance = (float)atof(argv[++i]);
+      continue;
+    }
+    if (arg == "--simplify" && i + 1 < argc)
+    {
+      simplify = (float)atof(argv[++i]);
+      continue;
+    }
+    if (arg == "--trace" && i + 1 < argc)
+    {
+      tracePath = argv[++i];
+      continue;
+    }
+    if (arg == "--cache" && i + 1 < argc)
+    {
+      cacheLimit = (size_t)(std::max(0.0, atof(argv[++i])) * 1024.0 * 1024.0);
+      continue;
+    }
+
+    size_t equals = arg.find('=');
+    if (equals == std::string::npos)
+    {
+      fprintf(stderr, "Expected name=value, got '%s'\n", arg.c_str());
+      return 1;
+    }
+    params[arg.substr(0, equals)] = arg.substr(equals + 1);
+  }
+
+  Common::SetTracing(!tracePath.empty());
+  Common::ResultCache::Shared().SetByteLimit(cacheLimit);
+
+  std::vector<PolygonLoop> loops;
+  std::string error;
+  Clock::time_point start = Clock::now();
+  if (!LoadGeometry(path, tolerance, &loops, &error))
+  {
+    fprintf(stderr, "%s\n", error.c_str());
+    return 1;
+  }
+  float loadMs = std::chrono::duration<float, std::milli>(Clock::now() - start).count();
+
+  size_t vertexCount = 0;
+  for (auto const &loop : loops)
+    vertexCount += loop.Size();
+
+  ModuleInitData initData{};
+  Module *pModule = pRunner->Create(&initData);
+  if (!pRunner->Configure(pModule, params, &error))
+  {
+    fprintf(stderr, "%s\n", error.c_str());
+    delete pModule;
+    return 1;
+  }
+  Common::Simplifier *pSimplifier = pRunner->GetSimplifier(pModule);
+  pSimplifier->SetTolerance(simplify);
+
+  // Repeated runs pass the same geometry again, so modules that cache results
+  // report their warm cost after the first run. Use --cache 0 to time every run cold.
+  std::vector<float> runMs;
+  bool success = true;
+  for (int r = 0; r < repeat; r++)
+  {
+    start = Clock::now();
+    success = pModule->SetGeometry(loops) && success;
+    runMs.push_back(std::chrono::duration<float, std::milli>(Clock::now() - start).count());
+  }
+
+  float totalMs = 0.f;
+  for (float ms : runMs)
+    totalMs += ms;
+
+  printf("Module: %s\n", pRunner->name);
+  printf("Loops: %zu\n", loops.size());
+  printf("Input vertices: %zu\n", vertexCount);
+  printf("Load: %.3f ms\n", loadMs);
+  printf("SetGeometry: %s\n", success ? "ok" : "failed");
+  printf("SetGeometry first: %.3f ms\n", runMs.front());
+  if (repeat > 1)
+  {
+    printf("SetGeometry min: %.3f ms\n", *std::min_element(runMs.begin(), runMs.end()));
+    printf("SetGeometry max: %.3f ms\n", *std::max_element(runMs.begin(), runMs.end()));
+    printf("SetGeometry avg: %.3f ms (%d runs)\n", totalMs / (float)repeat, repeat);
+  }
+
+  Common::SimplifyStats const &simplifyStats = pSimplifier->GetStats();
+  printf("Simplify tolerance: %g\n", pSimplifier->GetTolerance());
+  printf("Simplified vertices: %zu (%.1f%%)\n", simplifyStats.outputVertices,
+         vertexCount == 0 ? 100.0 : 100.0 * (double)simplifyStats.outputVertices / (double)vertexCount);
+  printf("Dropped loops: %zu\n", simplifyStats.droppedLoops);
+  printf("Restored loops: %zu\n", simplifyStats.restoredLoops);
+  printf("Simplify: %.3f ms\n", simplifyStats.ms);
+
+  // Counts are for the last rebuild, so with --repeat they show the warm state.
+  Common::ArenaStats arenaStats = pRunner->GetArena(pModule)->GetStats();
+  printf("Arena allocations: %zu\n", (size_t)arenaStats.allocations);
+  printf("Arena bytes: %zu (peak %zu)\n", (size_t)arenaStats.bytes, (size_t)arenaStats.peakBytes);
+  printf("Arena blocks: %zu (%zu bytes over %zu resets)\n", (size_t)arenaStats.heapAllocations,
+         (size_t)arenaStats.heapBytes, (size_t)arenaStats.resets);
+
+  if (pRunner->Query != nullptr)
+    pRunner->Query(pModule, params, loops);
+  pRunner->PrintStats(pModule);
+
+  // Busy time above wall time means the job ran on more than one core.
+  std::vector<Common::PoolStats> poolStats;
+  Common::ThreadPool::Shared().GetStats(&poolStats);
+  printf("Pool threads: %u\n", Common::ThreadPool::Shared().ThreadCount());
+  for (auto const &stats : poolStats)
+  {
+    printf("Pool %s: %zu jobs, %zu tasks, %.3f ms busy, %.3f ms wall\n", stats.category.c_str(),
+           (size_t)stats.jobs, (size_t)stats.tasks, stats.busyMs, stats.wallMs);
+  }
+
+  std::vector<Common::CacheStats> cacheStats;
+  Common::ResultCache::Shared().GetStats(&cacheStats);
+  for (auto const &stats : cacheStats)
+  {
+    printf("Cache %s: %zu hits, %zu misses, %zu evictions, %zu entries, %zu bytes\n", stats.category.c_str(),
+           (size_t)stats.hits, (size_t)stats.misses, (size_t)stats.evictions, (size_t)stats.entries, (size_t)stats.bytes);
+  }
+
+  if (!tracePath.empty())
+  {
+    Common::SetTracing(false);
+    if (!Common::WriteChromeTrace(tracePath.c_str()))
+      fprintf(stderr, "Could not write %s\n", tracePath.c_str());
+  }
+
+  delete pModule;
+  return success ? 0 : 2;
+}
\ No newline at end of file
@@ -0,0 +1,422 @@
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <cfloat>
+#include <chrono>
+#include <random>
+#include <algorithm>
+#include <initializer_list>
+
+#include "Modules.h"
+#include "FIPolyPoly.h"
+#include "Shadowing.h"
+#include "StraightSkeleton.h"
+#include "Triangulation.h"
+
+using namespace xn;
+
+typedef std::chrono::high_resolution_clock Clock;
+
+//----------------------------------------------------------------
+// Parameter parsing
+//----------------------------------------------------------------
+
+static bool CheckNames(Parameters const &params, std::initializer_list<char const *> names, std::string *pError)
+{
+  for (auto const &param : params)
+  {
+    bool known = false;
+    for (char const *name : names)
+      known = known || param.first == name;
+
+    if (!known)
+    {
+      *pError = "Unknown parameter '" + param.first + "'";
+      return false;
+    }
+  }
+  return true;
+}
+
+static bool ParseFloat(std::string const &text, float *pOut)
+{
+  char *pEnd = nullptr;
+  *pOut = strtof(text.c_str(), &pEnd);
+  return pEnd != text.c_str() && *pEnd == '\0';
+}
+
+static bool ParseInt(std::string const &text, int *pOut)
+{
+  char *pEnd = nullptr;
+  *pOut = (int)strtol(text.c_str(), &pEnd, 10);
+  return pEnd != text.c_str() && *pEnd == '\0';
+}
+
+static bool ParseBool(std::string const &text, bool *pOut)
+{
+  if (text == "1" || text == "true" || text == "on")
+  {
+    *pOut = true;
+    return true;
+  }
+  if (text == "0" || text == "false" || text == "off")
+  {
+    *pOut = false;
+    return true;
+  }
+  return false;
+}
+
+// Comma separated, eg '1,2.5,4'.
+static bool ParseFloatList(std::string const &text, std::vector<float> *pOut)
+{
+  pOut->clear();
+  size_t begin = 0;
+  while (begin <= text.size())
+  {
+    size_t end = text.find(',', begin);
+    if (end == std::string::npos)
+      end = text.size();
+
+    float value = 0.f;
+    if (!ParseFloat(text.substr(begin, end - begin), &value))
+      return false;
+    pOut->push_back(value);
+    begin = end + 1;
+  }
+  return true;
+}
+
+// Reads one parameter, if given, with the matching parser.
+template<typename T>
+static bool Get(Parameters const &params, char const *name, bool (*Parse)(std::string const &, T *), T *pOut, std::string *pError)
+{
+  auto it = params.find(name);
+  if (it == params.end())
+    return false;
+
+  if (!Parse(it->second, pOut))
+  {
+    *pError = "Bad value for '" + it->first + "': " + it->second;
+    return false;
+  }
+  return true;
+}
+
+static void GetBounds(std::vector<PolygonLoop> const &loops, vec2 *pMin, vec2 *pMax)
+{
+  vec2 minBounds(FLT_MAX, FLT_MAX);
+  vec2 maxBounds(-FLT_MAX, -FLT_MAX);
+  for (auto const &loop : loops)
+  {
+    for (auto it = loop.cPointsBegin(); it != loop.cPointsEnd(); it++)
+    {
+      vec2 p = *it;
+      for (int a = 0; a < 2; a++)
+      {
+        minBounds[a] = std::min(minBounds[a], p[a]);
+        maxBounds[a] = std::max(maxBounds[a], p[a]);
+      }
+    }
+  }
+  *pMin = minBounds;
+  *pMax = maxBounds;
+}
+
+//----------------------------------------------------------------
+// FIPolyPoly
+//----------------------------------------------------------------
+
+static Module *CreateFIPolyPoly(ModuleInitData *pData)
+{
+  return new FIPolyPoly(pData);
+}
+
+static Common::Simplifier *GetFIPolyPolySimplifier(Module *pModule)
+{
+  return &static_cast<FIPolyPoly *>(pModule)->GetSimplifier();
+}
+
+static Common::Arena const *GetFIPolyPolyArena(Module *pModule)
+{
+  return &static_cast<FIPolyPoly *>(pModule)->GetArena();
+}
+
+static bool ConfigureFIPolyPoly(Module *pModule, Parameters const &params, std::string *pError)
+{
+  FIPolyPoly *pFI = static_cast<FIPolyPoly *>(pModule);
+  if (!CheckNames(params, {"overlay"}, pError))
+    return false;
+
+  bool overlay = false;
+  if (Get(params, "overlay", ParseBool, &overlay, pError))
+    pFI->SetOverlay(overlay);
+  return pError->empty();
+}
+
+static void PrintFIPolyPoly(Module *pModule)
+{
+  FIPolyPoly *pFI = static_cast<FIPolyPoly *>(pModule);
+  printf("Pairs: %zu\n", pFI->GetPairCount());
+  printf("Rejected by broad phase: %zu\n", pFI->GetRejectedPairs());
+  printf("Recomputed: %zu\n", pFI->GetRecomputedPairs());
+  printf("Failed: %zu\n", pFI->GetFailedPairs());
+  printf("Intersecting: %zu\n", pFI->GetIntersectCount());
+  printf("Broad phase: %.3f ms\n", pFI->GetBroadPhaseMs());
+  printf("Overlay faces: %zu\n", pFI->GetOverlayFaceCount());
+  printf("Max overlap: %zu\n", pFI->GetOverlayMaxDepth());
+  printf("Overlay: %.3f ms\n", pFI->GetOverlayMs());
+}
+
+//----------------------------------------------------------------
+// Shadowing
+//----------------------------------------------------------------
+
+static Module *CreateShadowing(ModuleInitData *pData)
+{
+  return new Shadowing(pData);
+}
+
+static Common::Simplifier *GetShadowingSimplifier(Module *pModule)
+{
+  return &static_cast<Shadowing *>(pModule)->GetSimplifier();
+}
+
+static Common::Arena const *GetShadowingArena(Module *pModule)
+{
+  return &static_cast<Shadowing *>(pModule)->GetArena();
+}
+
+static bool ParseVec2(std::string const &text, vec2 *pOut)
+{
+  std::vector<float> values;
+  if (!ParseFloatList(text, &values) || values.size() != 2)
+    return false;
+  *pOut = vec2(values[0], values[1]);
+  return true;
+}
+
+static bool ConfigureShadowing(Module *pModule, Parameters const &params, std::string *pError)
+{
+  Shadowing *pShadowing = static_cast<Shadowing *>(pModule);
+  if (!CheckNames(params, {"source", "sweep"}, pError))
+    return false;
+
+  vec2 source(0.f, 0.f);
+  if (Get(params, "source", ParseVec2, &source, pError))
+    pShadowing->SetSource(source);
+
+  int sweep = 0;
+  Get(params, "sweep", ParseInt, &sweep, pError);
+  return pError->empty();
+}
+
+// Moves the source through 'sweep' random points inside the bounds of the input.
+static void QueryShadowing(Module *pModule, Parameters const &params, std::vector<PolygonLoop> const &loops)
+{
+  Shadowing *pShadowing = static_cast<Shadowing *>(pModule);
+  auto it = params.find("sweep");
+  if (it == params.end())
+    return;
+
+  int count = atoi(it->second.c_str());
+  vec2 minBounds, maxBounds;
+  GetBounds(loops, &minBounds, &maxBounds);
+
+  std::mt19937 rng(42);
+  std::uniform_real_distribution<float> x(minBounds.x(), maxBounds.x());
+  std::uniform_real_distribution<float> y(minBounds.y(), maxBounds.y());
+
+  size_t vertexTotal = 0;
+  Clock::time_point start = Clock::now();
+  for (int i = 0; i < count; i++)
+  {
+    pShadowing->SetSource(vec2(x(rng), y(rng)));
+    vertexTotal += pShadowing->GetVisibleRegion().Size();
+  }
+  float ms = std::chrono::duration<float, std::milli>(Clock::now() - start).count();
+
+  printf("Sweep: %d sources in %.3f ms (%.3f ms each)\n", count, ms, count > 0 ? ms / (float)count : 0.f);
+  printf("Sweep visible vertices: %zu\n", vertexTotal);
+}
+
+static void PrintShadowing(Module *pModule)
+{
+  Shadowing *pShadowing = static_cast<Shadowing *>(pModule);
+  printf("Visible region vertices: %zu\n", (size_t)pShadowing->GetVisibleRegion().Size());
+}
+
+//----------------------------------------------------------------
+// StraightSkeleton
+//----------------------------------------------------------------
+
+static Module *CreateStraightSkeleton(ModuleInitData *pData)
+{
+  return new StraightSkeleton(pData);
+}
+
+static Common::Simplifier *GetStraightSkeletonSimplifier(Module *pModule)
+{
+  return &static_cast<StraightSkeleton *>(pModule)->GetSimplifier();
+}
+
+static Common::Arena const *GetStraightSkeletonArena(Module *pModule)
+{
+  return &static_cast<StraightSkeleton *>(pModule)->GetArena();
+}
+
+static bool ConfigureStraightSkeleton(Module *pModule, Parameters const &params, std::string *pError)
+{
+  StraightSkeleton *pSkeleton = static_cast<StraightSkeleton *>(pModule);
+  if (!CheckNames(params, {"validate", "check", "offsets"}, pError))
+    return false;
+
+  bool flag = false;
+  if (Get(params, "validate", ParseBool, &flag, pError))
+    pSkeleton->SetValidateBoundaryConnections(flag);
+  if (Get(params, "check", ParseBool, &flag, pError))
+    pSkeleton->SetCheckIntersections(flag);
+
+  std::vector<float> offsets;
+  if (Get(params, "offsets", ParseFloatList, &offsets, pError))
+    pSkeleton->SetOffsets(offsets);
+  return pError->empty();
+}
+
+static void PrintStraightSkeleton(Module *pModule)
+{
+  StraightSkeleton *pSkeleton = static_cast<StraightSkeleton *>(pModule);
+  printf("Vertices: %zu\n", pSkeleton->GetVertexCount());
+  printf("Edges: %zu\n", pSkeleton->GetEdgeCount());
+  printf("Faces: %zu\n", pSkeleton->GetFaceCount());
+  printf("Segments: %zu\n", pSkeleton->GetSegmentCount());
+  printf("Reoriented loops: %zu\n", pSkeleton->GetReorientedCount());
+  for (size_t i = 0; i < pSkeleton->GetOffsetCount(); i++)
+  {
+    printf("Offset %.3f: %zu segments, %.3f ms\n", pSkeleton->GetOffsetDistance(i),
+      pSkeleton->GetOffsetSegmentCount(i), pSkeleton->GetOffsetMs(i));
+  }
+}
+
+//----------------------------------------------------------------
+// Triangulation
+//----------------------------------------------------------------
+
+static Module *CreateTriangulation(ModuleInitData *pData)
+{
+  return new Triangulation(pData);
+}
+
+static Common::Simplifier *GetTriangulationSimplifier(Module *pModule)
+{
+  return &static_cast<Triangulation *>(pModule)->GetSimplifier();
+}
+
+static Common::Arena const *GetTriangulationArena(Module *pModule)
+{
+  return &static_cast<Triangulation *>(pModule)->GetArena();
+}
+
+static bool ConfigureTriangulation(Module *pModule, Parameters const &params, std::string *pError)
+{
+  Triangulation *pTri = static_cast<Triangulation *>(pModule);
+  if (!CheckNames(params, {"size", "shape", "lloyd", "locate"}, pError))
+    return false;
+
+  float value = 0.f;
+  if (Get(params, "size", ParseFloat, &value, pError))
+    pTri->SetSizeCriteria(value);
+  if (Get(params, "shape", ParseFloat, &value, pError))
+    pTri->SetShapeCriteria(value);
+
+  int count = 0;
+  if (Get(params, "lloyd", ParseInt, &count, pError))
+    pTri->SetLloydIterations(count);
+  Get(params, "locate", ParseInt, &count, pError);
+  return pError->empty();
+}
+
+// The sliders rebuild the mesh without passing the geometry again.
+static bool ApplyTriangulation(Module *pModule, Parameters const &params, std::string *pError)
+{
+  if (!ConfigureTriangulation(pModule, params, pError))
+    return false;
+
+  static_cast<Triangulation *>(pModule)->Update();
+  return true;
+}
+
+// Locates 'locate' random points inside the bounds of the input in one batch.
+static void QueryTriangulation(Module *pModule, Parameters const &params, std::vector<PolygonLoop> const &loops)
+{
+  Triangulation *pTri = static_cast<Triangulation *>(pModule);
+  auto it = params.find("locate");
+  if (it == params.end())
+    return;
+
+  int count = atoi(it->second.c_str());
+  vec2 minBounds, maxBounds;
+  GetBounds(loops, &minBounds, &maxBounds);
+
+  std::mt19937 rng(42);
+  std::uniform_real_distribution<float> x(minBounds.x(), maxBounds.x());
+  std::uniform_real_distribution<float> y(minBounds.y(), maxBounds.y());
+
+  std::vector<vec2> points((size_t)std::max(count, 0));
+  for (auto &point : points)
+    point = vec2(x(rng), y(rng));
+
+  std::vector<MeshIndex::Location> locations(points.size());
+  Clock::time_point start = Clock::now();
+  pTri->GetMeshIndex().Locate(points.data(), points.size(), locations.data());
+  float ms = std::chrono::duration<float, std::milli>(Clock::now() - start).count();
+
+  size_t hits = 0;
+  for (auto const &location : locations)
+  {
+    if (location.triangle != MeshIndex::InvalidIndex)
+      hits++;
+  }
+
+  printf("Locate: %zu points in %.3f ms\n", points.size(), ms);
+  printf("Locate hits: %zu\n", hits);
+}
+
+static void PrintTriangulation(Module *pModule)
+{
+  Triangulation *pTri = static_cast<Triangulation *>(pModule);
+  printf("Vertices: %zu\n", pTri->GetVertexCount());
+  printf("Faces: %zu\n", pTri->GetFaceCount());
+  printf("Domain faces: %zu\n", pTri->GetDomainFaceCount());
+  printf("From cache: %s\n", pTri->IsFromCache() ? "yes" : "no");
+  printf("Edges: %zu\n", pTri->GetEdgeCount());
+  printf("Edge LODs: %zu\n", pTri->GetLodCount());
+  for (int i = 0; i < Triangulation::StageCount; i++)
+    printf("%s: %.3f ms\n", Triangulation::GetStageName(i), pTri->GetLastTiming(i));
+}
+
+//----------------------------------------------------------------
+// Registry
+//----------------------------------------------------------------
+
+std::vector<ModuleRunner> const &GetModuleRunners()
+{
+  static std::vector<ModuleRunner> const s_runners =
+  {
+    {"FIPolyPoly", "overlay=0|1", CreateFIPolyPoly, GetFIPolyPolySimplifier, GetFIPolyPolyArena, ConfigureFIPolyPoly, ConfigureFIPolyPoly, nullptr, PrintFIPolyPoly},
+    {"Shadowing", "source=x,y sweep=N", CreateShadowing, GetShadowingSimplifier, GetShadowingArena, ConfigureShadowing, ConfigureShadowing, QueryShadowing, PrintShadowing},
+    {"StraightSkeleton", "validate=0|1 check=0|1 offsets=d0,d1,...", CreateStraightSkeleton, GetStraightSkeletonSimplifier, GetStraightSkeletonArena, ConfigureStraightSkeleton, ConfigureStraightSkeleton, nullptr, PrintStraightSkeleton},
+    {"Triangulation", "size=S shape=S lloyd=N locate=N", CreateTriangulation, GetTriangulationSimplifier, GetTriangulationArena, ConfigureTriangulation, ApplyTriangulation, QueryTriangulation, PrintTriangulation}
+  };
+  return s_runners;
+}
+
+ModuleRunner const *FindModuleRunner(std::string const &name)
+{
+  for (auto const &runner : GetModuleRunners())
+  {
+    if (name == runner.name)
+      return &runner;
+  }
+  return nullptr;
+}
\ No newline at end of file
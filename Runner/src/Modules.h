@@ -0,0 +1,38 @@
+#ifndef MODULES_H
+#define MODULES_H
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "xnModule.h"
+#include "xnGeometry.h"
+#include "xnModuleInitData.h"
+#include "Simplify.h"
+#include "Arena.h"
+
+typedef std::map<std::string, std::string> Parameters;
+
+// Drives one sample module from the command line. Configure applies parameters
+// before SetGeometry, Query runs any queries against the result afterwards, and
+// PrintStats writes the result statistics to stdout. Apply changes parameters
+// after SetGeometry and reruns whatever the module's UI reruns for them.
+// GetSimplifier and GetArena return the module's input simplification stage
+// and scratch arena.
+struct ModuleRunner
+{
+  char const *name;
+  char const *usage;
+  xn::Module *(*Create)(xn::ModuleInitData *);
+  Common::Simplifier *(*GetSimplifier)(xn::Module *);
+  Common::Arena const *(*GetArena)(xn::Module *);
+  bool (*Configure)(xn::Module *, Parameters const &, std::string *pError);
+  bool (*Apply)(xn::Module *, Parameters const &, std::string *pError);
+  void (*Query)(xn::Module *, Parameters const &, std::vector<xn::PolygonLoop> const &);
+  void (*PrintStats)(xn::Module *);
+};
+
+std::vector<ModuleRunner> const &GetModuleRunners();
+ModuleRunner const *FindModuleRunner(std::string const &name);
+
+#endif
\ No newline at end of file
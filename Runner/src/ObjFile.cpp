@@ -0,0 +1,106 @@
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "ObjFile.h"
+
+using namespace xn;
+
+static bool ReadFile(std::string const &path, std::string *pOut)
+{
+  FILE *pFile = fopen(path.c_str(), "rb");
+  if (pFile == nullptr)
+    return false;
+
+  fseek(pFile, 0, SEEK_END);
+  long size = ftell(pFile);
+  fseek(pFile, 0, SEEK_SET);
+
+  pOut->resize(size < 0 ? 0 : (size_t)size);
+  size_t read = pOut->empty() ? 0 : fread(&(*pOut)[0], 1, pOut->size(), pFile);
+  fclose(pFile);
+  return read == pOut->size();
+}
+
+static char const *SkipSpaces(char const *p)
+{
+  while (*p == ' ' || *p == '\t' || *p == '\r')
+    p++;
+  return p;
+}
+
+bool ReadObj(std::string const &path, std::vector<PolygonLoop> *pLoops, std::string *pError)
+{
+  pLoops->clear();
+
+  std::string text;
+  if (!ReadFile(path, &text))
+  {
+    *pError = "Unable to read '" + path + "'";
+    return false;
+  }
+
+  std::vector<vec2> vertices;
+  std::vector<long> indices;
+  uint32_t lineNumber = 0;
+  char const *p = text.c_str();
+  while (*p != '\0')
+  {
+    lineNumber++;
+    p = SkipSpaces(p);
+
+    if (p[0] == 'v' && (p[1] == ' ' || p[1] == '\t'))
+    {
+      char *pEnd = nullptr;
+      float x = strtof(p + 1, &pEnd);
+      float y = strtof(pEnd, &pEnd);
+      vertices.push_back(vec2(x, y));
+      p = pEnd;
+    }
+    else if (p[0] == 'l' && (p[1] == ' ' || p[1] == '\t'))
+    {
+      indices.clear();
+      p++;
+      for (;;)
+      {
+        p = SkipSpaces(p);
+        if (*p == '\n' || *p == '\0')
+          break;
+
+        char *pEnd = nullptr;
+        long index = strtol(p, &pEnd, 10);
+        if (pEnd == p)
+          break;
+        p = pEnd;
+
+        // Skip any texture or normal index.
+        while (*p != ' ' && *p != '\t' && *p != '\r' && *p != '\n' && *p != '\0')
+          p++;
+
+        // Negative indices count back from the last vertex read.
+        index = index < 0 ? (long)vertices.size() + index : index - 1;
+        if (index < 0 || index >= (long)vertices.size())
+        {
+          *pError = "Bad vertex index on line " + std::to_string(lineNumber);
+          return false;
+        }
+        indices.push_back(index);
+      }
+
+      if (indices.size() > 1 && indices.front() == indices.back())
+        indices.pop_back();
+
+      PolygonLoop loop;
+      for (long index : indices)
+        loop.PushBack(vertices[index]);
+      pLoops->push_back(loop);
+    }
+
+    while (*p != '\n' && *p != '\0')
+      p++;
+    if (*p == '\n')
+      p++;
+  }
+
+  return true;
+}
\ No newline at end of file
@@ -0,0 +1,13 @@
+#ifndef OBJFILE_H
+#define OBJFILE_H
+
+#include <string>
+#include <vector>
+
+#include "xnGeometry.h"
+
+// Reads the 'v' and 'l' records of an OBJ file, as written by tools/svg_to_json.py.
+// Each 'l' record becomes one loop. A closing index that repeats the first is dropped.
+bool ReadObj(std::string const &path, std::vector<xn::PolygonLoop> *pLoops, std::string *pError);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,169 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <algorithm>
+
+#include "Replay.h"
+#include "Modules.h"
+#include "InputRecord.h"
+
+using namespace xn;
+
+typedef std::chrono::high_resolution_clock Clock;
+
+static char const *s_eventNames[] =
+{
+  "MouseDown",
+  "MouseMove",
+  "MouseUp",
+  "Value",
+  "SetGeometry"
+};
+
+static int const s_timedEventCount = sizeof(s_eventNames) / sizeof(s_eventNames[0]);
+
+static float Percentile(std::vector<float> const &sorted, float fraction)
+{
+  size_t index = std::min(sorted.size() - 1, (size_t)(fraction * (float)sorted.size()));
+  return sorted[index];
+}
+
+static void PrintTimes(char const *name, std::vector<float> times)
+{
+  if (times.empty())
+    return;
+
+  std::sort(times.begin(), times.end());
+  float total = 0.f;
+  for (float ms : times)
+    total += ms;
+
+  printf("%s: %zu, avg %.3f ms, p50 %.3f ms, p95 %.3f ms, max %.3f ms\n", name, times.size(),
+         total / (float)times.size(), Percentile(times, 0.5f), Percentile(times, 0.95f), times.back());
+}
+
+// The simplification tolerance is not a module parameter. Setting it only takes
+// effect on the next SetGeometry, which the recording holds as its own event.
+static bool ApplyValue(ModuleRunner const *pRunner, Module *pModule, std::string const &name,
+                       std::string const &value, std::string *pError)
+{
+  if (name == "simplify")
+  {
+    pRunner->GetSimplifier(pModule)->SetTolerance((float)atof(value.c_str()));
+    return true;
+  }
+
+  Parameters params;
+  params[name] = value;
+  return pRunner->Apply(pModule, params, pError);
+}
+
+bool ReplayRecording(std::string const &path, std::string *pError)
+{
+  Common::InputRecording recording;
+  if (!Common::ReadInputRecording(path.c_str(), &recording, pError))
+    return false;
+
+  ModuleRunner const *pRunner = FindModuleRunner(recording.module);
+  if (pRunner == nullptr)
+  {
+    *pError = "Unknown module '" + recording.module + "'";
+    return false;
+  }
+
+  float simplify = 0.f;
+  Parameters settings;
+  for (auto const &setting : recording.settings)
+  {
+    if (setting.first == "simplify")
+      simplify = (float)atof(setting.second.c_str());
+    else
+      settings[setting.first] = setting.second;
+  }
+
+  ModuleInitData initData{};
+  Module *pModule = pRunner->Create(&initData);
+  if (!pRunner->Configure(pModule, settings, pError))
+  {
+    delete pModule;
+    return false;
+  }
+  pRunner->GetSimplifier(pModule)->SetTolerance(simplify);
+
+  Clock::time_point start = Clock::now();
+  pModule->SetGeometry(recording.geometries.front());
+  float setupMs = std::chrono::duration<float, std::milli>(Clock::now() - start).count();
+
+  // Frames are timed by the events handled in them; rendering and the UI are not
+  // part of a headless run.
+  std::vector<float> eventTimes[s_timedEventCount];
+  std::vector<float> frameTimes;
+  size_t frameCount = 0;
+  float frameMs = 0.f;
+  bool frameHasEvents = false;
+  float replayMs = 0.f;
+  bool success = true;
+  for (auto const &event : recording.events)
+  {
+    if (event.type == Common::InputEventType::Frame)
+    {
+      frameCount++;
+      if (frameHasEvents)
+        frameTimes.push_back(frameMs);
+      frameMs = 0.f;
+      frameHasEvents = false;
+      continue;
+    }
+
+    start = Clock::now();
+    switch (event.type)
+    {
+      case Common::InputEventType::MouseDown:
+        pModule->MouseDown(event.modState, event.point);
+        break;
+      case Common::InputEventType::MouseMove:
+        pModule->MouseMove(event.modState, event.point);
+        break;
+      case Common::InputEventType::MouseUp:
+        pModule->MouseUp(event.modState);
+        break;
+      case Common::InputEventType::Value:
+        success = ApplyValue(pRunner, pModule, event.name, event.value, pError);
+        break;
+      case Common::InputEventType::Geometry:
+        pModule->SetGeometry(recording.geometries[event.geometry]);
+        break;
+      default:
+        break;
+    }
+    float ms = std::chrono::duration<float, std::milli>(Clock::now() - start).count();
+
+    if (!success)
+      break;
+
+    eventTimes[(int)event.type].push_back(ms);
+    frameMs += ms;
+    frameHasEvents = true;
+    replayMs += ms;
+  }
+
+  if (frameHasEvents)
+    frameTimes.push_back(frameMs);
+
+  if (success)
+  {
+    printf("Module: %s\n", pRunner->name);
+    printf("Events: %zu over %.3f s recorded\n", recording.events.size(),
+           recording.events.empty() ? 0.0 : recording.events.back().ms * 1.e-3);
+    printf("Geometries: %zu\n", recording.geometries.size());
+    printf("Setup SetGeometry: %.3f ms\n", setupMs);
+    for (int i = 0; i < s_timedEventCount; i++)
+      PrintTimes(s_eventNames[i], eventTimes[i]);
+    printf("Frames: %zu, %zu with input\n", frameCount, frameTimes.size());
+    PrintTimes("Frame cost", frameTimes);
+    printf("Replay: %.3f ms\n", replayMs);
+  }
+
+  delete pModule;
+  return success;
+}
\ No newline at end of file
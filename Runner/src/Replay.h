@@ -0,0 +1,12 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <string>
+
+// Replays an input recording (see Common/InputRecord.h) on a new instance of the
+// recorded module, as fast as it will go, and prints the time each event took to
+// handle and the time spent handling each frame's events. Returns false, with
+// pError set, if the recording cannot be read or a value cannot be applied.
+bool ReplayRecording(std::string const &path, std::string *pError);
+
+#endif
\ No newline at end of file
@@ -17,6 +17,7 @@ project "FIPolyPoly"
   includedirs
   {
     "src",
+    "%{wks.location}/Common/src",
     "%{wks.location}/XornCore/src",
     "%{wks.location}/DgLib/src"
   }
@@ -24,12 +25,14 @@ project "FIPolyPoly"
   links
   {
     "DgLib",
-	"XornCOre"
+	"XornCOre",
+	"Common"
   }
   
   postbuildcommands 
   {
-    "{COPY} %{wks.location}/build/%{prj.name}-%{cfg.buildcfg}/FIPolyPoly.dll %{wks.location}/XornApp/Plugins/FIPolyPoly"
+    "{COPY} %{wks.location}/build/%{prj.name}-%{cfg.buildcfg}/FIPolyPoly.dll %{wks.location}/XornApp/Plugins/FIPolyPoly",
+    "{COPY} %{wks.location}/build/Common-%{cfg.buildcfg}/Common.dll %{wks.location}/XornApp/Plugins/FIPolyPoly"
   }
 
   filter "configurations:Debug"
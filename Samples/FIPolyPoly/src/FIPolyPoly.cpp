@@ -1,23 +1,33 @@
 
+#ifndef XN_HEADLESS
 #include <windows.h>
+#endif
+#include <cfloat>
+#include <chrono>
+#include <algorithm>
 
 #include "FIPolyPoly.h"
+#ifndef XN_HEADLESS
 #include "xnPluginAPI.h"
+#endif
 #include "xnVersion.h"
 #include "xnLogger.h"
 #include "xnModule.h"
 #include "xnIRenderer.h"
 #include "DgRNG_Local.h"
+#include "ThreadPool.h"
+#include "ResultCache.h"
 
 using namespace xn;
 
-DEFINE_STANDARD_EXPORTS
-DEFINE_DLLMAIN
-
 typedef Dg::impl_FI2PolygonPolygon::PolygonsToGraph<float> PolysToGraph;
 typedef Dg::Graph::GraphBuilder<float> GraphBuilder;
 typedef Dg::Graph::Node<float> Node;
 
+#ifndef XN_HEADLESS
+DEFINE_STANDARD_EXPORTS
+DEFINE_DLLMAIN
+
 Module *xnPlugin_CreateModule(ModuleInitData *pData)
 {
   return new FIPolyPoly(pData);
@@ -27,6 +37,7 @@ char const *xnPlugin_GetModuleName()
 {
   return "FIPolyPoly";
 }
+#endif
 
 class ColourGenerator
 {
@@ -54,154 +65,530 @@ private:
   Dg::RNG_Local m_rng;
 };
 
-FIPolyPoly::FIPolyPoly(xn::ModuleInitData *pData)
-  : Module(pData)
-  , m_showGraph(true)
-  , m_showSubPolygons(true)
+static char const *s_cacheCategory = "FIPolyPoly";
+
+static void WriteFaces(std::vector<OverlayFace> const &faces, Common::ResultWriter *pWriter)
 {
+  pWriter->Write<uint64_t>(faces.size());
+  for (auto const &face : faces)
+  {
+    pWriter->WritePoints(face.points);
+    pWriter->WriteArray(face.loops);
+    pWriter->Write(face.area);
+  }
+}
 
+static bool ReadFaces(std::vector<uint8_t> const &data, std::vector<OverlayFace> *pFaces)
+{
+  Common::ResultReader reader(data);
+  uint64_t count = 0;
+  if (!reader.Read(&count) || count > data.size())
+    return false;
+
+  pFaces->resize((size_t)count);
+  for (auto &face : *pFaces)
+  {
+    if (!reader.ReadPoints(&face.points) || !reader.ReadArray(&face.loops) || !reader.Read(&face.area))
+      return false;
+  }
+  return true;
 }
 
-static void DrawGraph(Graph const &graph, xn::IRenderer *pRenderer)
+struct LoopBounds
 {
-  float thickness = 3.f;
+  xn::vec2 minBounds;
+  xn::vec2 maxBounds;
+};
 
-  ColourGenerator clrGen(42);
-  for (auto it_node = graph.nodes.cbegin(); it_node != graph.nodes.cend(); it_node++)
+// Sort-and-sweep over the loop bounding boxes. Returns the (i, j), i < j, pairs
+// whose boxes overlap, in the order the pairwise loop would visit them.
+static std::vector<std::pair<uint32_t, uint32_t>> FindCandidatePairs(std::vector<xn::PolygonLoop> const &loops)
+{
+  XN_TRACE_SCOPE("FIPolyPoly", "BroadPhase");
+
+  std::vector<LoopBounds> bounds(loops.size());
+  for (size_t i = 0; i < loops.size(); i++)
   {
-    xn::vec2 p0 = it_node->vertex;
-    std::vector<xn::seg> lines;
-    for (auto it_neighbour = it_node->neighbours.cbegin(); it_neighbour != it_node->neighbours.cend(); it_neighbour++)
+    xn::vec2 minBounds(FLT_MAX, FLT_MAX);
+    xn::vec2 maxBounds(-FLT_MAX, -FLT_MAX);
+    for (auto it = loops[i].cPointsBegin(); it != loops[i].cPointsEnd(); it++)
     {
-      xn::vec2 p1 = graph.nodes[it_neighbour->id].vertex;
-      p1 = (p0 + p1) * 0.5f;
+      xn::vec2 p = *it;
+      for (int a = 0; a < 2; a++)
+      {
+        if (p[a] < minBounds[a]) minBounds[a] = p[a];
+        if (p[a] > maxBounds[a]) maxBounds[a] = p[a];
+      }
+    }
+    bounds[i].minBounds = minBounds;
+    bounds[i].maxBounds = maxBounds;
+  }
+
+  std::vector<uint32_t> order(loops.size());
+  for (uint32_t i = 0; i < (uint32_t)order.size(); i++)
+    order[i] = i;
+  std::sort(order.begin(), order.end(), [&bounds](uint32_t a, uint32_t b)
+    { return bounds[a].minBounds.x() < bounds[b].minBounds.x(); });
 
-      lines.push_back(xn::seg(p0, p1));
+  std::vector<std::pair<uint32_t, uint32_t>> pairs;
+  std::vector<uint32_t> active;
+  for (uint32_t i : order)
+  {
+    LoopBounds const &box = bounds[i];
+    for (size_t a = 0; a < active.size();)
+    {
+      LoopBounds const &other = bounds[active[a]];
+      if (other.maxBounds.x() < box.minBounds.x())
+      {
+        active[a] = active.back();
+        active.pop_back();
+        continue;
+      }
+
+      if (other.minBounds.y() <= box.maxBounds.y() && other.maxBounds.y() >= box.minBounds.y())
+        pairs.push_back(std::pair<uint32_t, uint32_t>(std::min(i, active[a]), std::max(i, active[a])));
+      a++;
     }
-    pRenderer->DrawLineGroup(lines.data(), lines.size(), thickness, clrGen.NextColour(), 0);
+    active.push_back(i);
   }
 
-  Dg::DynamicArray<xn::vec2> nodes;
-  for (auto it_node = graph.nodes.cbegin(); it_node != graph.nodes.cend(); it_node++)
-    nodes.push_back(it_node->vertex);
+  std::sort(pairs.begin(), pairs.end());
+  return pairs;
+}
+
+FIPolyPoly::FIPolyPoly(xn::ModuleInitData *pData)
+  : Module(pData)
+  , m_subPolygonBatch(Common::InvalidDrawHandle)
+  , m_graphNodeBatch(Common::InvalidDrawHandle)
+  , m_overlayBatch(Common::InvalidDrawHandle)
+  , m_overlayFaceCount(0)
+  , m_overlayMaxDepth(0)
+  , m_overlayMs(0.f)
+  , m_pairCount(0)
+  , m_rejectedPairs(0)
+  , m_recomputedPairs(0)
+  , m_failedPairs(0)
+  , m_broadPhaseMs(0.f)
+  , m_overlay(false)
+  , m_showGraph(true)
+  , m_showSubPolygons(true)
+{
 
-  pRenderer->DrawFilledCircleGroup(nodes.data(), nodes.size(), 10.f, 0xFFFF00FF, 0);
 }
 
-static xn::DgPolygon ToPolygon(Dg::DynamicArray<Dg::Vector2<float>> const & verts, Dg::DynamicArray<uint32_t> const &indices)
+void FIPolyPoly::MouseDown(uint32_t modState, xn::vec2 const &p)
 {
-  xn::DgPolygon polygon;
-  for (size_t i = 0; i < indices.size(); i++)
-    polygon.PushBack(verts[indices[i]]);
-  return polygon;
+  XN_TRACE_MODULE_SCOPE(m_frameTimes, "FIPolyPoly", "MouseDown");
+  m_recorder.MouseDown(modState, p);
 }
 
-static PolygonResult ToPolygons(Result const &input)
+void FIPolyPoly::Render(xn::IRenderer *pRenderer)
 {
-  PolygonResult result;
-  result.boundary = ToPolygon(input.vertices, input.boundary);
+  XN_TRACE_MODULE_SCOPE(m_frameTimes, "FIPolyPoly", "Render");
 
-  for (size_t i = 0; i < input.polyA.size(); i++)
-    result.polyA.push_back(ToPolygon(input.vertices, input.polyA[i]));
+  if (m_overlay)
+  {
+    m_draws.Draw(m_overlayBatch, pRenderer);
+    return;
+  }
 
-  for (size_t i = 0; i < input.polyB.size(); i++)
-    result.polyB.push_back(ToPolygon(input.vertices, input.polyB[i]));
+  if (m_showGraph)
+  {
+    for (Common::DrawHandle handle : m_graphLineBatches)
+      m_draws.Draw(handle, pRenderer);
+    m_draws.Draw(m_graphNodeBatch, pRenderer);
+  }
 
-  for (size_t i = 0; i < input.intersection.size(); i++)
-    result.intersection.push_back(ToPolygon(input.vertices, input.intersection[i]));
+  if (m_showSubPolygons)
+    m_draws.Draw(m_subPolygonBatch, pRenderer);
+}
+
+bool FIPolyPoly::SetGeometry(std::vector<xn::PolygonLoop> const &loops)
+{
+  XN_TRACE_MODULE_SCOPE(m_frameTimes, "FIPolyPoly", "SetGeometry");
+  m_recorder.SetGeometry(loops);
+  m_loops = m_simplifier.Run(loops);
 
-  for (size_t i = 0; i < input.holes.size(); i++)
-    result.holes.push_back(ToPolygon(input.vertices, input.holes[i]));
+  if (m_overlay)
+    UpdateOverlay();
+  else
+    UpdatePairs();
 
-  return result;
+  return true;
 }
 
-static void DrawPolygons(PolygonResult const &result, xn::IRenderer *pRenderer)
+void FIPolyPoly::SetOverlay(bool overlay)
 {
-  pRenderer->DrawPolygon(result.boundary, 3.f, 0xFFFFFFFF, 0);
+  if (overlay == m_overlay)
+    return;
+
+  m_overlay = overlay;
+  if (m_overlay)
+    UpdateOverlay();
+  else
+    UpdatePairs();
+}
 
-  for (size_t i = 0; i < result.polyA.size(); i++)
-    pRenderer->DrawFilledPolygon(result.polyA[i], 0xFF0000FF, 0);
+void FIPolyPoly::UpdateOverlay()
+{
+  m_arena.Reset();
+  m_intersects.clear();
+  m_disjointPairs.clear();
+  BuildGraphBatches();
+  BuildSubPolygonBatch();
+
+  Common::ContentHash hash;
+  hash.AddLoops(m_loops);
+  uint64_t key = hash.Value();
+
+  typedef std::chrono::high_resolution_clock Clock;
+  Clock::time_point start = Clock::now();
+  std::vector<OverlayFace> faces;
+  Common::CachedResult pResult = Common::ResultCache::Shared().Find(s_cacheCategory, key);
+  if (pResult == nullptr || !ReadFaces(*pResult, &faces))
+  {
+    BuildOverlay(m_loops, &faces);
 
-  for (size_t i = 0; i < result.polyB.size(); i++)
-    pRenderer->DrawFilledPolygon(result.polyB[i], 0xFFFF0000, 0);
+    Common::ResultWriter writer;
+    WriteFaces(faces, &writer);
+    Common::ResultCache::Shared().Insert(s_cacheCategory, key, std::move(writer.Data()));
+  }
+  m_overlayMs = std::chrono::duration<float, std::milli>(Clock::now() - start).count();
 
-  for (size_t i = 0; i < result.intersection.size(); i++)
-    pRenderer->DrawFilledPolygon(result.intersection[i], 0xFF00FF00, 0);
+  // Faces come largest first, so nested faces are drawn over the face around them.
+  std::vector<xn::DgPolygon> polygons(faces.size());
+  std::vector<Common::PolygonStyle> styles(faces.size());
+  m_overlayMaxDepth = 0;
 
-  for (size_t i = 0; i < result.holes.size(); i++)
-    pRenderer->DrawFilledPolygon(result.holes[i], 0xFF000000, 0);
-}
+  std::vector<xn::Colour> depthColours;
+  ColourGenerator clrGen(42);
+  for (size_t i = 0; i < faces.size(); i++)
+  {
+    size_t depth = faces[i].loops.size();
+    while (depthColours.size() < depth)
+      depthColours.push_back(clrGen.NextColour());
+
+    for (auto const &point : faces[i].points)
+      polygons[i].PushBack(point);
+    styles[i] = Common::PolygonStyle{depthColours[depth - 1], 0xFFFFFFFF, 1.f, true};
+    m_overlayMaxDepth = std::max(m_overlayMaxDepth, depth);
+  }
 
-void FIPolyPoly::MouseDown(uint32_t modState, xn::vec2 const &)
-{
+  m_overlayFaceCount = faces.size();
+  m_overlayBatch = m_draws.SetPolygons(m_overlayBatch, std::move(polygons), std::move(styles));
 }
 
-void FIPolyPoly::Render(xn::IRenderer *pRenderer)
+void FIPolyPoly::UpdatePairs()
 {
-  if (m_showGraph)
+  m_draws.Release(m_overlayBatch);
+  m_overlayBatch = Common::InvalidDrawHandle;
+  m_overlayFaceCount = 0;
+  m_overlayMaxDepth = 0;
+
+  m_arena.Reset();
+  std::pmr::memory_resource *pScratch = m_arena.Resource();
+
+  std::vector<xn::PolygonLoop> const &loops = m_loops;
+
+  std::pmr::vector<uint64_t> hashes(loops.size(), pScratch);
+  for (size_t i = 0; i < loops.size(); i++)
+    hashes[i] = Common::HashLoop(loops[i]);
+
+  // Only pairs whose bounding boxes overlap go on to the narrow phase.
+  typedef std::chrono::high_resolution_clock Clock;
+  Clock::time_point start = Clock::now();
+  std::vector<std::pair<uint32_t, uint32_t>> candidates = FindCandidatePairs(loops);
+  m_broadPhaseMs = std::chrono::duration<float, std::milli>(Clock::now() - start).count();
+
+  m_pairCount = loops.size() < 2 ? 0 : loops.size() * (loops.size() - 1) / 2;
+  m_rejectedPairs = m_pairCount - candidates.size();
+
+  // Results are keyed by the content of both loops, so a pair whose loops did not
+  // change is carried over, wherever its loops now sit in the list. Pairs of
+  // removed loops are simply not carried over.
+  std::pmr::unordered_map<PairKey, size_t, PairKeyHash> previous(pScratch);
+  for (size_t i = 0; i < m_intersects.size(); i++)
+    previous.insert(std::make_pair(PairKey{m_intersects[i].hashA, m_intersects[i].hashB}, i));
+
+  std::pmr::vector<IntersectPair> kept(pScratch);
+  std::pmr::vector<bool> taken(m_intersects.size(), false, pScratch);
+  std::unordered_set<PairKey, PairKeyHash> disjointPairs;
+  std::pmr::vector<size_t> pending(pScratch);
+  for (size_t c = 0; c < candidates.size(); c++)
   {
-    for (auto const &intersect : m_intersects)
-      DrawGraph(intersect.graph, pRenderer);
+    uint32_t i = candidates[c].first;
+    uint32_t j = candidates[c].second;
+    PairKey key = {hashes[i], hashes[j]};
+
+    auto it = previous.find(key);
+    if (it != previous.end() && !taken[it->second])
+    {
+      taken[it->second] = true;
+      kept.push_back(std::move(m_intersects[it->second]));
+      kept.back().loopA = i;
+      kept.back().loopB = j;
+    }
+    else if (m_disjointPairs.find(key) != m_disjointPairs.end())
+    {
+      disjointPairs.insert(key);
+    }
+    else
+    {
+      pending.push_back(c);
+    }
   }
+  m_intersects.clear();
+  m_recomputedPairs = pending.size();
+
+  // The pair's graph is built here to learn whether the loops intersect, and kept
+  // for display while the graph is shown. Only intersecting pairs go on to the
+  // query, which builds the same graph again internally: FI2PolygonPolygon takes
+  // no prebuilt graph. Pairs are independent, so they run on the pool, each
+  // thread appending to its own buffers. Errors are logged from this thread once every pair is done.
+  // Failed pairs are not known to be disjoint, so they are not cached and are
+  // retried on the next rebuild.
+  struct PairError
+  {
+    uint32_t i;
+    uint32_t j;
+    char const *message;
+  };
+
+  Common::ThreadPool &pool = Common::ThreadPool::Shared();
+  std::vector<std::vector<IntersectPair>> threadOutputs(pool.ThreadCount());
+  std::vector<std::vector<PairKey>> threadDisjoint(pool.ThreadCount());
+  std::vector<std::vector<PairError>> threadErrors(pool.ThreadCount());
+  bool keepGraphs = m_showGraph;
+  pool.ParallelFor(pending.size(), [&](size_t p, uint32_t thread)
+  {
+    XN_TRACE_SCOPE("FIPolyPoly", "IntersectPair");
+    uint32_t i = candidates[pending[p]].first;
+    uint32_t j = candidates[pending[p]].second;
 
-  if (m_showSubPolygons)
+    Graph graph;
+    PolysToGraph polysToGraph;
+    auto code = polysToGraph.Execute(loops[i], loops[j], &graph);
+
+    if (code == Dg::QueryCode::Fail)
+    {
+      threadErrors[thread].push_back(PairError{i, j, "Failed to add polygons to graph"});
+      return;
+    }
+
+    GraphBuilder builder;
+    code = builder.Execute(&graph);
+
+    if (code == Dg::QueryCode::Fail)
+    {
+      threadErrors[thread].push_back(PairError{i, j, "Failed to build graph"});
+      return;
+    }
+
+    if (code != Dg::QueryCode::Intersecting)
+    {
+      threadDisjoint[thread].push_back(PairKey{hashes[i], hashes[j]});
+      return;
+    }
+
+    IntersectPair intersect;
+    intersect.loopA = i;
+    intersect.loopB = j;
+    intersect.hashA = hashes[i];
+    intersect.hashB = hashes[j];
+    intersect.hasGraph = keepGraphs;
+    if (keepGraphs)
+      intersect.graph = std::move(graph);
+
+    Query query;
+    intersect.result = query(loops[i], loops[j]);
+
+    threadOutputs[thread].push_back(std::move(intersect));
+  }, "FIPolyPoly");
+
+  for (auto const &keys : threadDisjoint)
+    disjointPairs.insert(keys.begin(), keys.end());
+  m_disjointPairs.swap(disjointPairs);
+
+  std::vector<PairError> errors;
+  for (auto const &threadError : threadErrors)
+    errors.insert(errors.end(), threadError.begin(), threadError.end());
+  std::sort(errors.begin(), errors.end(), [](PairError const &a, PairError const &b)
+    { return a.i < b.i || (a.i == b.i && a.j < b.j); });
+  for (auto const &error : errors)
+    M_LOG_ERROR("%s %i, %i", error.message, error.i, error.j);
+  m_failedPairs = errors.size();
+
+  // Merge in (i, j) order so the result does not depend on scheduling.
+  std::pmr::vector<IntersectPair *> outputs(pScratch);
+  for (auto &output : kept)
+    outputs.push_back(&output);
+  for (auto &threadOutput : threadOutputs)
   {
-    for (auto const &intersect : m_intersects)
-      DrawPolygons(intersect.polygons, pRenderer);
+    for (auto &output : threadOutput)
+      outputs.push_back(&output);
   }
+  std::sort(outputs.begin(), outputs.end(), [](IntersectPair const *a, IntersectPair const *b)
+    { return a->loopA < b->loopA || (a->loopA == b->loopA && a->loopB < b->loopB); });
+
+  for (IntersectPair *pOutput : outputs)
+    m_intersects.push_back(std::move(*pOutput));
+  BuildSubPolygonBatch();
+
+  if (m_showGraph)
+    BuildGraphs();
+  else
+    BuildGraphBatches();
 }
 
-bool FIPolyPoly::SetGeometry(std::vector<xn::PolygonLoop> const &loops)
+void FIPolyPoly::BuildGraphs()
 {
-  m_intersects.clear();
+  XN_TRACE_SCOPE("FIPolyPoly", "BuildGraphs");
 
-  for (size_t i = 0; i < loops.size(); i++)
+  std::vector<char const *> errors(m_intersects.size(), nullptr);
+  Common::ThreadPool::Shared().ParallelFor(m_intersects.size(), [&](size_t index, uint32_t)
   {
-    for (size_t j = i + 1; j < loops.size(); j++)
+    IntersectPair &intersect = m_intersects[index];
+    if (intersect.hasGraph)
+      return;
+
+    intersect.graph = Graph();
+    intersect.hasGraph = true;
+
+    PolysToGraph polysToGraph;
+    auto code = polysToGraph.Execute(m_loops[intersect.loopA], m_loops[intersect.loopB], &intersect.graph);
+
+    if (code == Dg::QueryCode::Fail)
     {
-      Graph graph;
-      PolysToGraph polysToGraph;
+      errors[index] = "Failed to add polygons to graph";
+      return;
+    }
 
-      auto code = polysToGraph.Execute(loops[i], loops[j], &graph);
+    GraphBuilder builder;
+    code = builder.Execute(&intersect.graph);
 
-      if (code == Dg::QueryCode::Fail)
-      {
-        M_LOG_ERROR("Failed to add polygons to graph %i, %i", i, j);
-        continue;
-      }
+    if (code == Dg::QueryCode::Fail)
+      errors[index] = "Failed to build graph";
+  }, "FIPolyPoly");
 
-      GraphBuilder builder;
-      code = builder.Execute(&graph);
+  // Log from this thread, in pair order.
+  for (size_t index = 0; index < errors.size(); index++)
+  {
+    if (errors[index] != nullptr)
+      M_LOG_ERROR("%s %i, %i", errors[index], m_intersects[index].loopA, m_intersects[index].loopB);
+  }
 
-      if (code == Dg::QueryCode::Fail)
-      {
-        M_LOG_ERROR("Failed to build graph %i, %i", i, j);
-        continue;
-      }
+  BuildGraphBatches();
+}
 
-      if (code != Dg::QueryCode::Intersecting)
-        continue;
+void FIPolyPoly::BuildGraphBatches()
+{
+  std::vector<std::vector<xn::seg>> lines(m_graphColours.size());
+  std::vector<xn::vec2> nodes;
 
-      //M_LOG_DEBUG("Intersect pair: %i, %i", i, j);
+  // Node colours come from the seed 42 sequence. Skip past the ones already
+  // cached, so a node index past them gets the colour it always had.
+  ColourGenerator clrGen(42);
+  for (size_t i = 0; i < m_graphColours.size(); i++)
+    clrGen.NextColour();
 
-      IntersectPair intersect;
-      intersect.graph = graph;
+  for (auto const &intersect : m_intersects)
+  {
+    if (!intersect.hasGraph)
+      continue;
+
+    Graph const &graph = intersect.graph;
+    size_t nodeIndex = 0;
+    for (auto it_node = graph.nodes.cbegin(); it_node != graph.nodes.cend(); it_node++, nodeIndex++)
+    {
+      if (nodeIndex == m_graphColours.size())
+        m_graphColours.push_back(clrGen.NextColour());
+      if (nodeIndex == lines.size())
+        lines.push_back(std::vector<xn::seg>());
 
-      Query query;
-      intersect.result = query(loops[i], loops[j]);
+      xn::vec2 p0 = it_node->vertex;
+      for (auto it_neighbour = it_node->neighbours.cbegin(); it_neighbour != it_node->neighbours.cend(); it_neighbour++)
+      {
+        xn::vec2 p1 = graph.nodes[it_neighbour->id].vertex;
+        p1 = (p0 + p1) * 0.5f;
 
-      intersect.polygons = ToPolygons(intersect.result);
+        lines[nodeIndex].push_back(xn::seg(p0, p1));
+      }
 
-      m_intersects.push_back(intersect);
+      nodes.push_back(it_node->vertex);
     }
   }
 
-  return true;
+  m_graphLineBatches.resize(lines.size(), Common::InvalidDrawHandle);
+  for (size_t i = 0; i < lines.size(); i++)
+    m_graphLineBatches[i] = m_draws.SetLineGroup(m_graphLineBatches[i], std::move(lines[i]), 3.f, m_graphColours[i]);
+  m_graphNodeBatch = m_draws.SetCircleGroup(m_graphNodeBatch, std::move(nodes), 10.f, 0xFFFF00FF);
+}
+
+// One batch for every pair, drawn in pair order: the boundary outline, then the
+// sub-polygons of each kind. The batch takes each result's vertices and index
+// lists as they are, offset into one shared buffer.
+void FIPolyPoly::BuildSubPolygonBatch()
+{
+  size_t vertexCount = 0;
+  for (auto const &intersect : m_intersects)
+    vertexCount += intersect.result.vertices.size();
+
+  std::vector<xn::vec2> vertices;
+  std::vector<uint32_t> indices;
+  std::vector<Common::IndexedPolygon> polygons;
+  vertices.reserve(vertexCount);
+  for (auto const &intersect : m_intersects)
+  {
+    Result const &result = intersect.result;
+    uint32_t base = (uint32_t)vertices.size();
+    for (size_t i = 0; i < result.vertices.size(); i++)
+      vertices.push_back(result.vertices[i]);
+
+    auto add = [&](Dg::DynamicArray<uint32_t> const &polygon, Common::PolygonStyle const &style)
+    {
+      polygons.push_back(Common::IndexedPolygon{(uint32_t)indices.size(), (uint32_t)polygon.size(), style});
+      for (size_t i = 0; i < polygon.size(); i++)
+        indices.push_back(base + polygon[i]);
+    };
+    auto addFilled = [&](auto const &subPolygons, xn::Colour colour)
+    {
+      for (size_t i = 0; i < subPolygons.size(); i++)
+        add(subPolygons[i], Common::PolygonStyle{colour, colour, 0.f, true});
+    };
+
+    add(result.boundary, Common::PolygonStyle{0xFFFFFFFF, 0xFFFFFFFF, 3.f, false});
+    addFilled(result.polyA, 0xFF0000FF);
+    addFilled(result.polyB, 0xFFFF0000);
+    addFilled(result.intersection, 0xFF00FF00);
+    addFilled(result.holes, 0xFF000000);
+  }
+  m_subPolygonBatch = m_draws.SetIndexedPolygons(m_subPolygonBatch, std::move(vertices), std::move(indices), std::move(polygons));
+}
+
+void FIPolyPoly::ReleaseGraphs()
+{
+  for (size_t i = 0; i < m_intersects.size(); i++)
+  {
+    m_intersects[i].graph = Graph();
+    m_intersects[i].hasGraph = false;
+  }
+  BuildGraphBatches();
+}
+
+void FIPolyPoly::StartRecording()
+{
+  m_recorder.Start("FIPolyPoly", m_simplifier.GetInput());
+  m_recorder.AddSetting("simplify", Common::FormatValue(m_simplifier.GetTolerance()));
+  m_recorder.AddSetting("overlay", Common::FormatValue(m_overlay));
 }
 
 void FIPolyPoly::_DoFrame(xn::UIContext *pContext)
 {
+  XN_TRACE_MODULE_SCOPE(m_frameTimes, "FIPolyPoly", "_DoFrame");
+  Common::ModulePanel panel{"FIPolyPoly", &m_frameTimes, &m_simplifier, &m_arena, &m_recorder, s_cacheCategory,
+                            [this]() { StartRecording(); },
+                            [this]() { SetGeometry(m_simplifier.GetInput()); }};
+
   if (pContext->Button("What is this?##FIPolyPoly"))
     pContext->OpenPopup("Description##FIPolyPoly");
   if (pContext->BeginPopup("Description##FIPolyPoly"))
@@ -212,9 +599,46 @@ void FIPolyPoly::_DoFrame(xn::UIContext *pContext)
     pContext->PopTextWrapPos();
     pContext->EndPopup();
   }
+  std::string error;
+  if (!Common::DoPanelHeader(pContext, panel, &error))
+    M_LOG_ERROR("%s", error.c_str());
+  Common::DrawStoreStats drawStats = m_draws.GetStats();
+  pContext->Text("Draw lists: %u batches, %.1f KB, %u uploads", (uint32_t)drawStats.batches, (float)drawStats.bytes / 1024.f, (uint32_t)drawStats.uploads);
+
+  pContext->Separator();
+
+  Common::DoSimplifyControls(pContext, panel);
+  pContext->Separator();
+
+  bool overlay = m_overlay;
+  if (pContext->Checkbox("Overlay all loops##FIPolyPoly", &overlay))
+  {
+    m_recorder.ValueChanged("overlay", Common::FormatValue(overlay));
+    SetOverlay(overlay);
+  }
 
+  if (m_overlay)
+  {
+    pContext->Text("Faces: %u", (uint32_t)m_overlayFaceCount);
+    pContext->Text("Max overlap: %u", (uint32_t)m_overlayMaxDepth);
+    pContext->Text("Overlay: %.3f ms", m_overlayMs);
+    return;
+  }
+
+  pContext->Text("Pairs: %u", (uint32_t)m_pairCount);
+  pContext->Text("Rejected by broad phase: %u", (uint32_t)m_rejectedPairs);
+  pContext->Text("Recomputed: %u", (uint32_t)m_recomputedPairs);
+  pContext->Text("Failed: %u", (uint32_t)m_failedPairs);
+  pContext->Text("Broad phase: %.3f ms", m_broadPhaseMs);
+  pContext->Text("Intersecting: %u", (uint32_t)m_intersects.size());
   pContext->Separator();
 
-  pContext->Checkbox("Show graph##FIPolyPoly", &m_showGraph);
+  if (pContext->Checkbox("Show graph##FIPolyPoly", &m_showGraph))
+  {
+    if (m_showGraph)
+      BuildGraphs();
+    else
+      ReleaseGraphs();
+  }
   pContext->Checkbox("Show subs##FIPolyPoly", &m_showSubPolygons);
 }
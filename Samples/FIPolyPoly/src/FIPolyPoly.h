@@ -2,6 +2,8 @@
 #define FIPOLYPOLY_H
 
 #include <vector>
+#include <unordered_map>
+#include <unordered_set>
 
 #include "xnModule.h"
 #include "xnCommon.h"
@@ -12,24 +14,42 @@
 #include "DgGraph.h"
 #include "DgQueryPolygonPolygon.h"
 
+#include "Arena.h"
+#include "DrawStore.h"
+#include "InputRecord.h"
+#include "ModulePanel.h"
+#include "Simplify.h"
+#include "Trace.h"
+#include "Overlay.h"
+
 typedef Dg::Graph::Graph_t<float>             Graph;
 typedef Dg::FI2PolygonPolygon<float>          Query;
 typedef Dg::FI2PolygonPolygon<float>::Result  Result;
 
-struct PolygonResult
-{
-  xn::DgPolygon boundary;
-  Dg::DynamicArray<xn::DgPolygon> polyA;
-  Dg::DynamicArray<xn::DgPolygon> polyB;
-  Dg::DynamicArray<xn::DgPolygon> intersection;
-  Dg::DynamicArray<xn::DgPolygon> holes;
-};
-
+// The result is kept in its indexed form: one vertex buffer shared by every
+// sub-polygon, which are index lists into it.
 struct IntersectPair
 {
+  uint32_t loopA;
+  uint32_t loopB;
+  uint64_t hashA;    // Content hashes of the two loops
+  uint64_t hashB;
+  bool hasGraph;     // The graph is only kept while it is being shown
   Graph graph;
   Result result;
-  PolygonResult polygons;
+};
+
+struct PairKey
+{
+  uint64_t hashA;
+  uint64_t hashB;
+
+  bool operator==(PairKey const &o) const { return hashA == o.hashA && hashB == o.hashB; }
+};
+
+struct PairKeyHash
+{
+  size_t operator()(PairKey const &key) const { return (size_t)(key.hashA ^ (key.hashB * 0x9E3779B97F4A7C15ull)); }
 };
 
 class FIPolyPoly : public xn::Module
@@ -43,14 +63,65 @@ public:
 
   bool SetGeometry(std::vector<xn::PolygonLoop> const &) override;
 
+  // Parameters and results, for driving the module without the UI.
+  void SetOverlay(bool overlay);
+  size_t GetPairCount() const { return m_pairCount; }
+  size_t GetRejectedPairs() const { return m_rejectedPairs; }
+  size_t GetRecomputedPairs() const { return m_recomputedPairs; }
+  size_t GetFailedPairs() const { return m_failedPairs; }
+  size_t GetIntersectCount() const { return m_intersects.size(); }
+  float GetBroadPhaseMs() const { return m_broadPhaseMs; }
+  size_t GetOverlayFaceCount() const { return m_overlayFaceCount; }
+  size_t GetOverlayMaxDepth() const { return m_overlayMaxDepth; }
+  float GetOverlayMs() const { return m_overlayMs; }
+  Common::Simplifier &GetSimplifier() { return m_simplifier; }
+  Common::Arena const &GetArena() const { return m_arena; }
+
 private:
 
   void _DoFrame(xn::UIContext *) override;
+  void StartRecording();
+  void UpdatePairs();
+  void UpdateOverlay();
+  void BuildGraphs();
+  void ReleaseGraphs();
+  void BuildGraphBatches();
+  void BuildSubPolygonBatch();
 
 private:
 
+  Common::Simplifier m_simplifier;
+  Common::Arena m_arena;
+  Common::InputRecorder m_recorder;
+  Common::FrameTimes m_frameTimes;
+  std::vector<xn::PolygonLoop> m_loops;
   Dg::DynamicArray<IntersectPair> m_intersects;
-
+  std::unordered_set<PairKey, PairKeyHash> m_disjointPairs; // Candidate pairs found not to intersect
+
+  // Everything drawn is uploaded here when the result changes, so Render only
+  // draws the batches.
+  Common::DrawStore m_draws;
+  Common::DrawHandle m_subPolygonBatch;
+
+  // Graph lines are grouped by colour, which is picked by node index.
+  std::vector<xn::Colour> m_graphColours;
+  std::vector<Common::DrawHandle> m_graphLineBatches;
+  Common::DrawHandle m_graphNodeBatch;
+
+  // Overlay mode: every face of the arrangement of all loops, coloured by how
+  // many loops cover it.
+  Common::DrawHandle m_overlayBatch;
+  size_t m_overlayFaceCount;
+  size_t m_overlayMaxDepth;
+  float m_overlayMs;
+
+  size_t m_pairCount;
+  size_t m_rejectedPairs;
+  size_t m_recomputedPairs;
+  size_t m_failedPairs;       // Logged, and retried on the next rebuild
+  float m_broadPhaseMs;
+
+  bool m_overlay;
   bool m_showGraph;
   bool m_showSubPolygons;
 };
@@ -0,0 +1,411 @@
+
+#include <cmath>
+#include <iterator>
+#include <set>
+#include <algorithm>
+
+#include "Overlay.h"
+#include "SegmentSweep.h"
+#include "Trace.h"
+
+using namespace xn;
+
+static uint32_t const s_invalid = 0xFFFFFFFF;
+
+namespace
+{
+  struct Split
+  {
+    uint32_t segment;
+    uint32_t vertex;
+    double t;
+  };
+
+  struct LoopEdge
+  {
+    uint32_t v0;
+    uint32_t v1;
+    uint32_t loop;
+  };
+
+  struct Edge
+  {
+    uint32_t v0;
+    uint32_t v1;
+    uint32_t loopsBegin; // Range into the shared edge loop list
+    uint32_t loopsEnd;
+  };
+
+  struct HalfEdge
+  {
+    uint32_t origin;
+    uint32_t edge;
+    uint32_t next;
+    uint32_t cycle;
+    double angle;
+  };
+
+  struct Cycle
+  {
+    uint32_t first;
+    double area;
+    bool labelled;
+  };
+
+  // Events of the sweep that finds the edge directly below each component.
+  // At equal x, queries come before removals, which come before insertions, so a
+  // query at x sees the edges with minX < x <= maxX.
+  enum class EventType
+  {
+    Query,
+    Remove,
+    Insert
+  };
+
+  struct Event
+  {
+    double x;
+    EventType type;
+    uint32_t index;   // Component root for queries, edge otherwise
+  };
+
+  // Orders the edges crossing the sweep line from bottom to top. Edges of the
+  // arrangement only meet at their end points, so the order only changes where
+  // edges are inserted or removed.
+  struct StatusOrder
+  {
+    typedef void is_transparent;
+
+    std::vector<Common::SweepPoint> const *pVertices;
+    std::vector<Edge> const *pEdges;
+    double const *pX;
+
+    void Ends(uint32_t e, Common::SweepPoint *pLeft, Common::SweepPoint *pRight) const
+    {
+      Common::SweepPoint const &a = (*pVertices)[(*pEdges)[e].v0];
+      Common::SweepPoint const &b = (*pVertices)[(*pEdges)[e].v1];
+      *pLeft = a.x < b.x ? a : b;
+      *pRight = a.x < b.x ? b : a;
+    }
+
+    double YAt(uint32_t e) const
+    {
+      Common::SweepPoint left, right;
+      Ends(e, &left, &right);
+      if (*pX <= left.x)
+        return left.y;
+      if (*pX >= right.x)
+        return right.y;
+      return left.y + (right.y - left.y) * (*pX - left.x) / (right.x - left.x);
+    }
+
+    double Slope(uint32_t e) const
+    {
+      Common::SweepPoint left, right;
+      Ends(e, &left, &right);
+      return (right.y - left.y) / (right.x - left.x);
+    }
+
+    // Edges inserted at a shared left end are ordered by where they go next.
+    bool operator()(uint32_t a, uint32_t b) const
+    {
+      double ya = YAt(a);
+      double yb = YAt(b);
+      if (ya != yb)
+        return ya < yb;
+      return Slope(a) < Slope(b);
+    }
+
+    bool operator()(uint32_t a, Common::SweepPoint const &p) const { return YAt(a) < p.y; }
+    bool operator()(Common::SweepPoint const &p, uint32_t a) const { return p.y < YAt(a); }
+  };
+}
+
+static uint32_t Find(std::vector<uint32_t> &parents, uint32_t v)
+{
+  while (parents[v] != v)
+  {
+    parents[v] = parents[parents[v]];
+    v = parents[v];
+  }
+  return v;
+}
+
+static void SymmetricDifference(std::vector<uint32_t> const &a, uint32_t const *pBegin, uint32_t const *pEnd, std::vector<uint32_t> *pOut)
+{
+  pOut->clear();
+  std::set_symmetric_difference(a.begin(), a.end(), pBegin, pEnd, std::back_inserter(*pOut));
+}
+
+void BuildOverlay(std::vector<xn::PolygonLoop> const &loops, std::vector<OverlayFace> *pFaces)
+{
+  XN_TRACE_SCOPE("FIPolyPoly", "BuildOverlay");
+
+  pFaces->clear();
+
+  // Gather every loop edge for the sweep.
+  std::vector<std::vector<Common::SweepPoint>> points(loops.size());
+  std::vector<Common::SweepSegment> segments;
+  std::vector<uint32_t> segmentLoops;
+  for (uint32_t l = 0; l < (uint32_t)loops.size(); l++)
+  {
+    for (auto it = loops[l].cPointsBegin(); it != loops[l].cPointsEnd(); it++)
+    {
+      vec2 p = *it;
+      Common::SweepPoint sp = {(double)p.x(), (double)p.y()};
+      points[l].push_back(sp);
+    }
+
+    std::vector<Common::SweepPoint> const &loop = points[l];
+    if (loop.size() < 3)
+      continue;
+
+    for (size_t i = 0; i < loop.size(); i++)
+    {
+      segments.push_back(Common::SweepSegment{loop[i], loop[(i + 1) % loop.size()]});
+      segmentLoops.push_back(l);
+    }
+  }
+
+  if (segments.empty())
+    return;
+
+  // Every meeting point becomes a vertex. Loop vertices are always meeting points,
+  // as the two loop edges either side of them meet there.
+  std::vector<Common::SweepPoint> vertices;
+  std::vector<Split> splits;
+  Common::SweepIntersections(segments, [&](Common::SweepPoint const &point, uint32_t const *pSegments, size_t count)
+  {
+    uint32_t vertex = (uint32_t)vertices.size();
+    vertices.push_back(point);
+    for (size_t i = 0; i < count; i++)
+    {
+      Common::SweepSegment const &s = segments[pSegments[i]];
+      double t = (point.x - s.p0.x) * (s.p1.x - s.p0.x) + (point.y - s.p0.y) * (s.p1.y - s.p0.y);
+      splits.push_back(Split{pSegments[i], vertex, t});
+    }
+    return true;
+  });
+
+  // Cut each segment at its meeting points.
+  std::sort(splits.begin(), splits.end(), [](Split const &a, Split const &b)
+    { return a.segment < b.segment || (a.segment == b.segment && a.t < b.t); });
+
+  std::vector<LoopEdge> loopEdges;
+  for (size_t i = 1; i < splits.size(); i++)
+  {
+    Split const &a = splits[i - 1];
+    Split const &b = splits[i];
+    if (a.segment != b.segment || a.vertex == b.vertex)
+      continue;
+    loopEdges.push_back(LoopEdge{std::min(a.vertex, b.vertex), std::max(a.vertex, b.vertex), segmentLoops[a.segment]});
+  }
+
+  // Edges shared by several loops, where loop edges overlap, are merged.
+  std::sort(loopEdges.begin(), loopEdges.end(), [](LoopEdge const &a, LoopEdge const &b)
+    { return a.v0 < b.v0 || (a.v0 == b.v0 && (a.v1 < b.v1 || (a.v1 == b.v1 && a.loop < b.loop))); });
+
+  std::vector<Edge> edges;
+  std::vector<uint32_t> edgeLoops;
+  for (size_t i = 0; i < loopEdges.size(); i++)
+  {
+    LoopEdge const &le = loopEdges[i];
+    if (edges.empty() || edges.back().v0 != le.v0 || edges.back().v1 != le.v1)
+      edges.push_back(Edge{le.v0, le.v1, (uint32_t)edgeLoops.size(), (uint32_t)edgeLoops.size()});
+    edgeLoops.push_back(le.loop);
+    edges.back().loopsEnd++;
+  }
+
+  // Half-edges 2e and 2e + 1 are the two sides of edge e.
+  std::vector<HalfEdge> halfEdges(edges.size() * 2);
+  for (uint32_t e = 0; e < (uint32_t)edges.size(); e++)
+  {
+    Common::SweepPoint const &p0 = vertices[edges[e].v0];
+    Common::SweepPoint const &p1 = vertices[edges[e].v1];
+    halfEdges[2 * e] = HalfEdge{edges[e].v0, e, s_invalid, s_invalid, std::atan2(p1.y - p0.y, p1.x - p0.x)};
+    halfEdges[2 * e + 1] = HalfEdge{edges[e].v1, e, s_invalid, s_invalid, std::atan2(p0.y - p1.y, p0.x - p1.x)};
+  }
+
+  // Outgoing half-edges around each vertex, counter-clockwise.
+  std::vector<uint32_t> outgoing(halfEdges.size());
+  for (uint32_t h = 0; h < (uint32_t)outgoing.size(); h++)
+    outgoing[h] = h;
+  std::sort(outgoing.begin(), outgoing.end(), [&halfEdges](uint32_t a, uint32_t b)
+  {
+    HalfEdge const &ha = halfEdges[a];
+    HalfEdge const &hb = halfEdges[b];
+    return ha.origin < hb.origin || (ha.origin == hb.origin && ha.angle < hb.angle);
+  });
+
+  std::vector<uint32_t> firstOutgoing(vertices.size() + 1, 0);
+  for (HalfEdge const &h : halfEdges)
+    firstOutgoing[h.origin + 1]++;
+  for (size_t v = 1; v < firstOutgoing.size(); v++)
+    firstOutgoing[v] += firstOutgoing[v - 1];
+
+  // The face left of u->v continues along the edge that comes just before v->u,
+  // turning clockwise around v.
+  for (uint32_t v = 0; v < (uint32_t)vertices.size(); v++)
+  {
+    uint32_t begin = firstOutgoing[v];
+    uint32_t degree = firstOutgoing[v + 1] - begin;
+    for (uint32_t i = 0; i < degree; i++)
+    {
+      uint32_t twin = outgoing[begin + i] ^ 1;
+      halfEdges[twin].next = outgoing[begin + (i + degree - 1) % degree];
+    }
+  }
+
+  // Trace the cycles. Bounded faces run counter-clockwise; the outer boundary of
+  // each connected group of edges runs clockwise.
+  std::vector<Cycle> cycles;
+  for (uint32_t h = 0; h < (uint32_t)halfEdges.size(); h++)
+  {
+    if (halfEdges[h].cycle != s_invalid)
+      continue;
+
+    uint32_t cycle = (uint32_t)cycles.size();
+    double area = 0.0;
+    uint32_t current = h;
+    do
+    {
+      HalfEdge &he = halfEdges[current];
+      he.cycle = cycle;
+      Common::SweepPoint const &a = vertices[he.origin];
+      Common::SweepPoint const &b = vertices[halfEdges[he.next].origin];
+      area += a.x * b.y - b.x * a.y;
+      current = he.next;
+    } while (current != h);
+
+    cycles.push_back(Cycle{h, area * 0.5, false});
+  }
+
+  // Group the vertices into connected components.
+  std::vector<uint32_t> parents(vertices.size());
+  for (uint32_t v = 0; v < (uint32_t)parents.size(); v++)
+    parents[v] = v;
+  for (Edge const &edge : edges)
+    parents[Find(parents, edge.v0)] = Find(parents, edge.v1);
+
+  std::vector<uint32_t> outerCycles(vertices.size(), s_invalid);
+  for (uint32_t c = 0; c < (uint32_t)cycles.size(); c++)
+  {
+    uint32_t root = Find(parents, halfEdges[cycles[c].first].origin);
+    if (outerCycles[root] == s_invalid || cycles[c].area < cycles[outerCycles[root]].area)
+      outerCycles[root] = c;
+  }
+
+  std::vector<uint32_t> leftmost(vertices.size(), s_invalid);
+  for (uint32_t v = 0; v < (uint32_t)vertices.size(); v++)
+  {
+    uint32_t root = Find(parents, v);
+    if (firstOutgoing[v] == firstOutgoing[v + 1])
+      continue;
+    if (leftmost[root] == s_invalid || vertices[v].x < vertices[leftmost[root]].x)
+      leftmost[root] = v;
+  }
+
+  // Label the cycles. The outside of a component lies in the face of the edge
+  // directly below its leftmost vertex, or outside every loop if there is none.
+  // Edges touching the vertex's x from the right are not counted, so that edge
+  // always belongs to another component, whose leftmost vertex lies further left.
+  // Sweeping left to right therefore labels that component first. From the
+  // outside, every edge crossed toggles its loops.
+  std::vector<Event> events;
+  for (uint32_t root = 0; root < (uint32_t)vertices.size(); root++)
+  {
+    if (outerCycles[root] != s_invalid)
+      events.push_back(Event{vertices[leftmost[root]].x, EventType::Query, root});
+  }
+  for (uint32_t e = 0; e < (uint32_t)edges.size(); e++)
+  {
+    double x0 = vertices[edges[e].v0].x;
+    double x1 = vertices[edges[e].v1].x;
+    if (x0 == x1)
+      continue;
+    events.push_back(Event{std::min(x0, x1), EventType::Insert, e});
+    events.push_back(Event{std::max(x0, x1), EventType::Remove, e});
+  }
+  std::sort(events.begin(), events.end(), [](Event const &a, Event const &b)
+    { return a.x < b.x || (a.x == b.x && a.type < b.type); });
+
+  double sweepX = 0.0;
+  typedef std::set<uint32_t, StatusOrder> Status;
+  Status status(StatusOrder{&vertices, &edges, &sweepX});
+  std::vector<Status::iterator> statusEntries(edges.size(), status.end());
+
+  std::vector<std::vector<uint32_t>> labels(cycles.size());
+  std::vector<uint32_t> stack;
+  std::vector<uint32_t> scratch;
+  for (Event const &event : events)
+  {
+    sweepX = event.x;
+    if (event.type == EventType::Insert)
+    {
+      statusEntries[event.index] = status.insert(event.index).first;
+      continue;
+    }
+    if (event.type == EventType::Remove)
+    {
+      status.erase(statusEntries[event.index]);
+      continue;
+    }
+
+    uint32_t root = event.index;
+    uint32_t outer = outerCycles[root];
+    Status::iterator above = status.lower_bound(vertices[leftmost[root]]);
+    if (above != status.begin())
+    {
+      // The side of the edge below that faces up is left of the half-edge running
+      // left to right.
+      uint32_t e = *std::prev(above);
+      uint32_t h = vertices[edges[e].v0].x < vertices[edges[e].v1].x ? 2 * e : 2 * e + 1;
+      labels[outer] = labels[halfEdges[h].cycle];
+    }
+    cycles[outer].labelled = true;
+
+    stack.push_back(outer);
+    while (!stack.empty())
+    {
+      uint32_t c = stack.back();
+      stack.pop_back();
+
+      uint32_t current = cycles[c].first;
+      do
+      {
+        HalfEdge const &he = halfEdges[current];
+        uint32_t other = halfEdges[current ^ 1].cycle;
+        if (!cycles[other].labelled)
+        {
+          Edge const &edge = edges[he.edge];
+          SymmetricDifference(labels[c], edgeLoops.data() + edge.loopsBegin, edgeLoops.data() + edge.loopsEnd, &scratch);
+          labels[other] = scratch;
+          cycles[other].labelled = true;
+          stack.push_back(other);
+        }
+        current = he.next;
+      } while (current != cycles[c].first);
+    }
+  }
+
+  for (uint32_t c = 0; c < (uint32_t)cycles.size(); c++)
+  {
+    if (cycles[c].area <= 0.0 || labels[c].empty())
+      continue;
+
+    OverlayFace face;
+    face.area = (float)cycles[c].area;
+    face.loops = labels[c];
+    uint32_t current = cycles[c].first;
+    do
+    {
+      Common::SweepPoint const &p = vertices[halfEdges[current].origin];
+      face.points.push_back(vec2((float)p.x, (float)p.y));
+      current = halfEdges[current].next;
+    } while (current != cycles[c].first);
+    pFaces->push_back(std::move(face));
+  }
+
+  std::stable_sort(pFaces->begin(), pFaces->end(), [](OverlayFace const &a, OverlayFace const &b)
+    { return a.area > b.area; });
+}
\ No newline at end of file
@@ -0,0 +1,28 @@
+#ifndef OVERLAY_H
+#define OVERLAY_H
+
+#include <stdint.h>
+#include <vector>
+
+#include "xnCommon.h"
+#include "xnGeometry.h"
+
+// A bounded face of the planar arrangement of a set of loops.
+struct OverlayFace
+{
+  std::vector<xn::vec2> points; // Counter-clockwise outer boundary
+  std::vector<uint32_t> loops;  // Indices of the loops covering the face, ascending
+  float area;                   // Enclosed by the boundary, so includes any nested faces
+};
+
+// Builds the arrangement of all loops at once. Edges are split where they meet
+// with one Bentley-Ottmann sweep, faces are traced from the resulting half-edge
+// structure, and each face is labelled by walking across edges from the outside,
+// toggling the loops that own each edge crossed. The outside of each connected
+// group of loops is found with a second sweep, as the face of the edge directly
+// below the group. Only faces covered by at least one loop are returned, largest
+// first, so faces nested in a larger face come after it. Runs in O((n + k) log n)
+// for n edges and k meeting points, plus the cost of copying the face labels.
+void BuildOverlay(std::vector<xn::PolygonLoop> const &loops, std::vector<OverlayFace> *pFaces);
+
+#endif
\ No newline at end of file
@@ -17,6 +17,7 @@ project "Shadowing"
   includedirs
   {
     "src",
+    "%{wks.location}/Common/src",
     "%{wks.location}/XornCore/src",
     "%{wks.location}/DgLib/src"
   }
@@ -24,12 +25,14 @@ project "Shadowing"
   links
   {
     "DgLib",
-	"XornCOre"
+	"XornCOre",
+	"Common"
   }
   
   postbuildcommands 
   {
-    "{COPY} %{wks.location}/build/%{prj.name}-%{cfg.buildcfg}/Shadowing.dll %{wks.location}/XornApp/Plugins/Shadowing"
+    "{COPY} %{wks.location}/build/%{prj.name}-%{cfg.buildcfg}/Shadowing.dll %{wks.location}/XornApp/Plugins/Shadowing",
+    "{COPY} %{wks.location}/build/Common-%{cfg.buildcfg}/Common.dll %{wks.location}/XornApp/Plugins/Shadowing"
   }
 
   filter "configurations:Debug"
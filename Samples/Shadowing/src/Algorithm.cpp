@@ -1,6 +1,7 @@
 
 #include <stdint.h>
 #include <cmath>
+#include <memory>
 #include <algorithm>
 
 #include "Algorithm.h"
@@ -11,6 +12,7 @@
 
 #include "xnGeometry.h"
 #include "DgRay.h"
+#include "Trace.h"
 
 using namespace xn;
 
@@ -107,7 +109,7 @@ public:
   PIMPL();
   ~PIMPL();
 
-  void SetRegion(std::vector<xn::PolygonLoop> const &loops);
+  void SetRegion(std::vector<xn::PolygonLoop> const &loops, std::pmr::memory_resource *pScratch);
   bool TryBuildVisibilityPolygon(vec2 const &source, DgPolygon *pOut);
 
 private:
@@ -124,8 +126,8 @@ private:
 
   std::vector<Vertex> m_regionVerts;
   Dg::Map_AVL<float, VisibilityRay> m_rays;
-  std::vector<bool> m_processedFlags;
-  RayVertex *m_pRayVerts;
+  bool *m_pProcessedFlags; // Scratch, sized to m_regionVerts
+  RayVertex *m_pRayVerts;  // Scratch, sized to m_regionVerts
   uint32_t m_rayVertsSize;
 };
 
@@ -136,7 +138,8 @@ VertexID const ID::s_InvalidID = 0xFFFFFFFF;
 //----------------------------------------------------------------
 
 VisibilityBuilder::PIMPL::PIMPL()
-  : m_pRayVerts(nullptr)
+  : m_pProcessedFlags(nullptr)
+  , m_pRayVerts(nullptr)
   , m_rayVertsSize(0)
 {
 
@@ -144,11 +147,13 @@ VisibilityBuilder::PIMPL::PIMPL()
 
 VisibilityBuilder::PIMPL::~PIMPL()
 {
-  delete[] m_pRayVerts;
+
 }
 
-void VisibilityBuilder::PIMPL::SetRegion(std::vector<xn::PolygonLoop> const &loops)
+void VisibilityBuilder::PIMPL::SetRegion(std::vector<xn::PolygonLoop> const &loops, std::pmr::memory_resource *pScratch)
 {
+  XN_TRACE_SCOPE("Shadowing", "SetRegion");
+
   m_regionVerts.clear();
   for (auto poly_it = loops.cbegin(); poly_it != loops.cend(); poly_it++)
   {
@@ -171,26 +176,30 @@ void VisibilityBuilder::PIMPL::SetRegion(std::vector<xn::PolygonLoop> const &loo
     }
   }
 
-  delete[] m_pRayVerts;
-  m_pRayVerts = new RayVertex[m_regionVerts.size()]{};
+  size_t count = m_regionVerts.size();
+  m_pRayVerts = static_cast<RayVertex *>(pScratch->allocate(count * sizeof(RayVertex), alignof(RayVertex)));
+  std::uninitialized_value_construct_n(m_pRayVerts, count);
 
-  m_processedFlags.resize(m_regionVerts.size());
+  m_pProcessedFlags = static_cast<bool *>(pScratch->allocate(count * sizeof(bool), alignof(bool)));
+  std::uninitialized_value_construct_n(m_pProcessedFlags, count);
 }
 
 bool VisibilityBuilder::PIMPL::TryBuildVisibilityPolygon(vec2 const &source, DgPolygon *pOut)
 {
+  XN_TRACE_SCOPE("Shadowing", "BuildVisibilityPolygon");
+
   float epsilon = Dg::Constants<float>::EPSILON;
 
   pOut->Clear();
   m_rays.clear();
 
-  std::fill(m_processedFlags.begin(), m_processedFlags.end(), false);
+  std::fill_n(m_pProcessedFlags, m_regionVerts.size(), false);
 
   for (VertexID vertIndex = 0; vertIndex < m_regionVerts.size(); vertIndex++)
   {
-    if (m_processedFlags[vertIndex])
+    if (m_pProcessedFlags[vertIndex])
       continue;
-    m_processedFlags[vertIndex] = true;
+    m_pProcessedFlags[vertIndex] = true;
 
     auto &vert = m_regionVerts[vertIndex];
 
@@ -265,7 +274,7 @@ void VisibilityBuilder::PIMPL::FindAllVertsOnRay(ray2 const &ray, VertexID start
 {
   for (VertexID vertIndex = startVertex; vertIndex < m_regionVerts.size(); vertIndex++)
   {
-    if (m_processedFlags[vertIndex])
+    if (m_pProcessedFlags[vertIndex])
       continue;
 
     auto &vert = m_regionVerts[vertIndex];
@@ -280,7 +289,7 @@ void VisibilityBuilder::PIMPL::FindAllVertsOnRay(ray2 const &ray, VertexID start
     if (d > epsilon)
       continue;
 
-    m_processedFlags[vertIndex] = true;
+    m_pProcessedFlags[vertIndex] = true;
     float lenSq = Dg::MagSq(vert.point - ray.Origin());
 
     m_pRayVerts[m_rayVertsSize].id.SetVertex(vertIndex);
@@ -405,7 +414,7 @@ bool VisibilityBuilder::PIMPL::IsConnected(VertexID id, VisibilityRay const &ray
     }
     else
     {
-      auto &const vert = m_regionVerts[ray.backID.GetFirst()];
+      auto const &vert = m_regionVerts[ray.backID.GetFirst()];
       a = vert.nextVertex;
       b = vert.prevVertex;
     }
@@ -463,9 +472,9 @@ VisibilityBuilder::~VisibilityBuilder()
   delete m_pimpl;
 }
 
-void VisibilityBuilder::SetRegion(std::vector<xn::PolygonLoop> const &loops)
+void VisibilityBuilder::SetRegion(std::vector<xn::PolygonLoop> const &loops, std::pmr::memory_resource *pScratch)
 {
-  m_pimpl->SetRegion(loops);
+  m_pimpl->SetRegion(loops, pScratch);
 }
 
 bool VisibilityBuilder::TryBuildVisibilityPolygon(xn::vec2 const &source, xn::DgPolygon *pOut)
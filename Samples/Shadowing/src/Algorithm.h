@@ -1,6 +1,8 @@
 #ifndef ALGORITHM_H
 #define ALGORITHM_H
 
+#include <memory_resource>
+
 #include "xnGeometry.h"
 
 class VisibilityBuilder
@@ -10,7 +12,9 @@ public:
   VisibilityBuilder();
   ~VisibilityBuilder();
 
-  void SetRegion(std::vector<xn::PolygonLoop> const &loops);
+  // Per-region buffers come from pScratch and are never freed individually, so it
+  // should be an arena that is reset only before the next SetRegion.
+  void SetRegion(std::vector<xn::PolygonLoop> const &loops, std::pmr::memory_resource *pScratch);
   bool TryBuildVisibilityPolygon(xn::vec2 const &source, xn::DgPolygon *pOut);
 
 private:
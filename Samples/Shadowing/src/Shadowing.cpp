@@ -1,12 +1,17 @@
 
+#ifndef XN_HEADLESS
 #include <windows.h>
+#endif
 
 #include "Shadowing.h"
+#ifndef XN_HEADLESS
 #include "xnPluginAPI.h"
+#endif
 #include "xnVersion.h"
 
 using namespace xn;
 
+#ifndef XN_HEADLESS
 DEFINE_STANDARD_EXPORTS
 DEFINE_DLLMAIN
 
@@ -19,9 +24,14 @@ char const *xnPlugin_GetModuleName()
 {
   return "Shadowing";
 }
+#endif
 
 Shadowing::Shadowing(ModuleInitData *pData)
   : Module(pData)
+  , m_frameTimes()
+  , m_simplifier()
+  , m_arena()
+  , m_recorder()
   , m_visibilityBuilder()
   , m_visibleRegion()
   , m_source(0.f, 0.f)
@@ -33,13 +43,34 @@ Shadowing::Shadowing(ModuleInitData *pData)
 
 bool Shadowing::SetGeometry(std::vector<PolygonLoop> const &loops)
 {
-  m_visibilityBuilder.SetRegion(loops);
+  XN_TRACE_MODULE_SCOPE(m_frameTimes, "Shadowing", "SetGeometry");
+  m_recorder.SetGeometry(loops);
+  m_arena.Reset();
+  m_visibilityBuilder.SetRegion(m_simplifier.Run(loops), m_arena.Resource());
   m_visibilityBuilder.TryBuildVisibilityPolygon(m_source, &m_visibleRegion);
   return true;
 }
 
+void Shadowing::SetSource(vec2 const &source)
+{
+  m_source = source;
+  m_visibilityBuilder.TryBuildVisibilityPolygon(m_source, &m_visibleRegion);
+}
+
+void Shadowing::StartRecording()
+{
+  m_recorder.Start("Shadowing", m_simplifier.GetInput());
+  m_recorder.AddSetting("simplify", Common::FormatValue(m_simplifier.GetTolerance()));
+  m_recorder.AddSetting("source", Common::FormatValue(m_source));
+}
+
 void Shadowing::_DoFrame(UIContext *pContext)
 {
+  XN_TRACE_MODULE_SCOPE(m_frameTimes, "Shadowing", "_DoFrame");
+  Common::ModulePanel panel{"Shadowing", &m_frameTimes, &m_simplifier, &m_arena, &m_recorder, nullptr,
+                            [this]() { StartRecording(); },
+                            [this]() { SetGeometry(m_simplifier.GetInput()); }};
+
   if (pContext->Button("What is this?##Shadowing"))
     pContext->OpenPopup("Description##Shadowing");
   if (pContext->BeginPopup("Description##Shadowing"))
@@ -50,27 +81,35 @@ void Shadowing::_DoFrame(UIContext *pContext)
     pContext->PopTextWrapPos();
     pContext->EndPopup();
   }
+  std::string error;
+  if (!Common::DoPanelHeader(pContext, panel, &error))
+    M_LOG_ERROR("%s", error.c_str());
   pContext->Separator();
-
   pContext->Checkbox("Show vertices##Shadowing", &m_showVertices);
+  Common::DoSimplifyControls(pContext, panel);
 
   static float stepSize = 1.f;
   pContext->InputFloat("Step size##Shadowing", &stepSize, 1.f, 10.f);
-  if (pContext->InputFloat("x##Shadowing", &m_source.x(), stepSize, stepSize))
-    m_visibilityBuilder.TryBuildVisibilityPolygon(m_source, &m_visibleRegion);
-  if (pContext->InputFloat("y##Shadowing", &m_source.y(), stepSize, stepSize))
+  bool sourceChanged = pContext->InputFloat("x##Shadowing", &m_source.x(), stepSize, stepSize);
+  sourceChanged = pContext->InputFloat("y##Shadowing", &m_source.y(), stepSize, stepSize) || sourceChanged;
+  if (sourceChanged)
+  {
+    m_recorder.ValueChanged("source", Common::FormatValue(m_source));
     m_visibilityBuilder.TryBuildVisibilityPolygon(m_source, &m_visibleRegion);
-
+  }
 }
 
 void Shadowing::Render(IRenderer *pRenderer)
 {
+  XN_TRACE_MODULE_SCOPE(m_frameTimes, "Shadowing", "Render");
   pRenderer->DrawFilledPolygon(m_visibleRegion, 0xFFCCCCCC, 0);
   pRenderer->DrawFilledCircle(m_source, 10.f, 0xFFFF00FF, 0);
 }
 
 void Shadowing::MouseDown(uint32_t modState, vec2 const &p)
 {
+  XN_TRACE_MODULE_SCOPE(m_frameTimes, "Shadowing", "MouseDown");
+  m_recorder.MouseDown(modState, p);
   m_source = p;
   m_mouseDown = true;
   m_visibilityBuilder.TryBuildVisibilityPolygon(m_source, &m_visibleRegion);
@@ -78,11 +117,15 @@ void Shadowing::MouseDown(uint32_t modState, vec2 const &p)
 
 void Shadowing::MouseUp(uint32_t modState)
 {
+  XN_TRACE_MODULE_SCOPE(m_frameTimes, "Shadowing", "MouseUp");
+  m_recorder.MouseUp(modState);
   m_mouseDown = false;
 }
 
 void Shadowing::MouseMove(uint32_t modState, vec2 const &p)
 {
+  XN_TRACE_MODULE_SCOPE(m_frameTimes, "Shadowing", "MouseMove");
+  m_recorder.MouseMove(modState, p);
   if (m_mouseDown)
   {
     m_source = p;
@@ -10,6 +10,11 @@
 #include "xnIRenderer.h"
 #include "xnLogger.h"
 
+#include "Arena.h"
+#include "InputRecord.h"
+#include "ModulePanel.h"
+#include "Simplify.h"
+#include "Trace.h"
 #include "Algorithm.h"
 
 class Shadowing : public xn::Module
@@ -25,12 +30,23 @@ public:
 
   bool SetGeometry(std::vector<xn::PolygonLoop> const &) override;
 
+  // For driving the module without the UI.
+  void SetSource(xn::vec2 const &source);
+  Dg::Polygon2<float> const &GetVisibleRegion() const { return m_visibleRegion; }
+  Common::Simplifier &GetSimplifier() { return m_simplifier; }
+  Common::Arena const &GetArena() const { return m_arena; }
+
 private:
 
   void _DoFrame(xn::UIContext *) override;
+  void StartRecording();
 
 private:
 
+  Common::FrameTimes m_frameTimes;
+  Common::Simplifier m_simplifier;
+  Common::Arena m_arena;
+  Common::InputRecorder m_recorder;
   VisibilityBuilder m_visibilityBuilder;
   Dg::Polygon2<float> m_visibleRegion;
   xn::vec2 m_source;
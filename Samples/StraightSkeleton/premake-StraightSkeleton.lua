@@ -58,6 +58,7 @@ project "StraightSkeleton"
     vcpkgPackageDir .. "/boost-static-assert_x64-windows/include",
     vcpkgPackageDir .. "/boost-detail_x64-windows/include",
     "src",
+    "%{wks.location}/Common/src",
     "%{wks.location}/XornCore/src",
     "%{wks.location}/DgLib/src"
   }
@@ -67,12 +68,14 @@ project "StraightSkeleton"
     vcpkgPackageDir .. "/gmp_x64-windows/lib/gmp.lib",
     vcpkgPackageDir .. "/mpfr_x64-windows/lib/mpfr.lib",
     "DgLib",
-	"XornCOre"
+	"XornCOre",
+	"Common"
   }
   
   postbuildcommands 
   {
     "{COPY} %{wks.location}/build/%{prj.name}-%{cfg.buildcfg}/StraightSkeleton.dll %{wks.location}/XornApp/Plugins/StraightSkeleton",
+    "{COPY} %{wks.location}/build/Common-%{cfg.buildcfg}/Common.dll %{wks.location}/XornApp/Plugins/StraightSkeleton",
     "{COPY} " .. vcpkgPackageDir .. "/gmp_x64-windows/bin/gmp-10.dll %{wks.location}/XornApp/Plugins/StraightSkeleton",
     "{COPY} " .. vcpkgPackageDir .. "/mpfr_x64-windows/bin/mpfr-6.dll %{wks.location}/XornApp/Plugins/StraightSkeleton"
   }
@@ -1,16 +1,29 @@
 
+#ifndef XN_HEADLESS
 #include <windows.h>
+#endif
+#include <stdio.h>
+#include <chrono>
+#include <string>
+#include <algorithm>
 
 #include <CGAL/Exact_predicates_inexact_constructions_kernel.h>
 #include <CGAL/Polygon_with_holes_2.h>
 #include <CGAL/create_straight_skeleton_from_polygon_with_holes_2.h>
+#include <CGAL/create_offset_polygons_2.h>
 #include <boost/shared_ptr.hpp>
 
 #include "StraightSkeleton.h"
+#ifndef XN_HEADLESS
 #include "xnPluginAPI.h"
+#endif
 #include "xnVersion.h"
 #include <DgQuery.h>
 #include <DgQuerySegmentSegment.h>
+#include "ThreadPool.h"
+#include "ResultCache.h"
+#include "SegmentSweep.h"
+#include "Trace.h"
 
 typedef CGAL::Exact_predicates_inexact_constructions_kernel K;
 typedef K::Point_2                    Point;
@@ -22,15 +35,23 @@ typedef boost::shared_ptr<Ss> SsPtr;
 
 using namespace xn;
 
-DEFINE_STANDARD_EXPORTS
-DEFINE_DLLMAIN
+static char const *s_cacheCategory = "StraightSkeleton";
+
+class StraightSkeleton::PIMPL
+{
+public:
+
+  // One per region, kept after SetGeometry so offsets can be generated
+  // without rebuilding them.
+  std::vector<SsPtr> skeletons;
+};
 
-vec2 ToDgVec(Point const &p)
+static vec2 ToDgVec(Point const &p)
 {
   return vec2((float)p.x(), (float)p.y());
 }
 
-Dg::QueryCode IntersectsBoundary(DgPolygon const &poly, seg const &s)
+static Dg::QueryCode IntersectsBoundary(DgPolygon const &poly, seg const &s)
 {
   Dg::QueryCode result = Dg::QueryCode::NotIntersecting;
 
@@ -48,6 +69,10 @@ Dg::QueryCode IntersectsBoundary(DgPolygon const &poly, seg const &s)
   return result;
 }
 
+#ifndef XN_HEADLESS
+DEFINE_STANDARD_EXPORTS
+DEFINE_DLLMAIN
+
 Module *xnPlugin_CreateModule(ModuleInitData *pData)
 {
   return new StraightSkeleton(pData);
@@ -57,119 +82,495 @@ char const *xnPlugin_GetModuleName()
 {
   return "Straight Skeleton";
 }
+#endif
 
 StraightSkeleton::StraightSkeleton(ModuleInitData *pData)
   : Module(pData)
+  , m_pimpl(new PIMPL())
+  , m_simplifier()
+  , m_arena()
+  , m_recorder()
+  , m_frameTimes()
+  , m_offsets()
+  , m_showOffsets(true)
   , m_segments()
   , m_vertCount(0)
   , m_edgeCount(0)
   , m_faceCount(0)
   , m_showBoundaryConnections(false)
+  , m_validateBoundaryConnections(false)
+  , m_checkIntersections(true)
+  , m_reorientedCount(0)
+  , m_resultKey(0)
+  , m_skeletonsPending(false)
   //, m_edgeProperties(0xFFFF00FF, 2.f)
 {
+  Offset offset = {};
+  offset.distance = 1.f;
+  offset.dirty = true;
+  m_offsets.push_back(offset);
+}
 
+StraightSkeleton::~StraightSkeleton()
+{
+  delete m_pimpl;
 }
 
 void StraightSkeleton::Clear()
 {
+  ClearSkeletons();
+  for (auto &offset : m_offsets)
+  {
+    offset.segments.clear();
+    offset.ms = 0.f;
+    offset.dirty = true;
+  }
+}
+
+void StraightSkeleton::ClearSkeletons()
+{
+  m_pimpl->skeletons.clear();
+  m_skeletonsPending = false;
   m_segments.clear();
   m_boundaryConnections.clear();
   m_vertCount = 0;
   m_edgeCount = 0;
   m_faceCount = 0;
+  m_reorientedCount = 0;
 }
 
-bool StraightSkeleton::SetGeometry(std::vector<PolygonLoop> const &loops)
+// Everything one region job produces. Jobs share nothing, so they can run at once.
+struct RegionResult
 {
-  Clear();
-
-  auto polygons = BuildPolygonsWithHoles(loops);
-
-  PolygonWithHoles polygon;
-  if (!polygons.empty())
-    polygon = polygons.front();
+  SsPtr skeleton;
+  std::vector<seg> segments;
+  std::vector<seg> boundaryConnections;
+  size_t vertCount;
+  size_t edgeCount;
+  size_t faceCount;
+  size_t mismatches;
+  size_t reoriented;
+  std::string error;
+};
+
+static void BuildRegion(PolygonWithHoles const &polygon, bool validate, bool checkIntersections, RegionResult *pOut)
+{
+  XN_TRACE_SCOPE("StraightSkeleton", "BuildRegion");
 
   if (polygon.loops.size() == 0)
-    return true;
-
-  Polygon2 outer;
-  auto poly_it = polygon.loops.cbegin();
-
-  for (auto it = poly_it->cPointsBegin(); it != poly_it->cPointsEnd(); it++)
-    outer.push_back(Point(it->x(), it->y()));
-  
-  if (!outer.is_counterclockwise_oriented())
-  {
-    M_LOG_ERROR("Failed to create straight skeleton: output polygon is not CCW");
-    return false;
-  }
+    return;
 
-  Polygon_with_holes poly(outer);
-  poly_it++;
-  for (; poly_it != polygon.loops.cend(); poly_it++)
+  // One linear pass per loop: convert it, and use its signed area to put it in the
+  // winding CGAL expects, CCW for the outer loop and CW for holes.
+  std::vector<Polygon2> contours;
+  std::vector<std::vector<Common::SweepPoint>> sweepLoops;
+  for (auto poly_it = polygon.loops.cbegin(); poly_it != polygon.loops.cend(); poly_it++)
   {
-    Polygon2 hole;
+    Polygon2 contour;
+    std::vector<Common::SweepPoint> points;
+    double area = 0.0;
     for (auto it = poly_it->cPointsBegin(); it != poly_it->cPointsEnd(); it++)
-      hole.push_back(Point(it->x(), it->y()));
+    {
+      Common::SweepPoint p = {it->x(), it->y()};
+      if (!points.empty())
+        area += points.back().x * p.y - p.x * points.back().y;
+      points.push_back(p);
+      contour.push_back(Point(p.x, p.y));
+    }
 
-    if (!hole.is_clockwise_oriented())
+    if (points.size() < 3)
     {
-      M_LOG_ERROR("Failed to create straight skeleton: hole polygon is not CW");
-      return false;
+      pOut->error = "loop has fewer than 3 vertices";
+      return;
     }
+    area += points.back().x * points.front().y - points.front().x * points.back().y;
 
-    poly.add_hole(hole);
+    if (area == 0.0)
+    {
+      pOut->error = "loop has no area";
+      return;
+    }
+
+    bool isOuter = contours.empty();
+    if ((area > 0.0) != isOuter)
+    {
+      contour.reverse_orientation();
+      pOut->reoriented++;
+    }
+
+    contours.push_back(contour);
+    sweepLoops.push_back(std::move(points));
   }
 
+  // Reject bad input here, before CGAL does any expensive work.
+  if (checkIntersections && Common::LoopsIntersect(sweepLoops))
+  {
+    pOut->error = "region boundary intersects itself";
+    return;
+  }
+
+  Polygon_with_holes poly(contours[0]);
+  for (size_t i = 1; i < contours.size(); i++)
+    poly.add_hole(contours[i]);
+
   SsPtr iss = CGAL::create_interior_straight_skeleton_2(poly);
 
   if (iss == nullptr)
   {
-    M_LOG_ERROR("Failed to create straight skeleton");
-    return false;
+    pOut->error = "CGAL could not build the skeleton";
+    return;
   }
 
-  typedef typename Ss::Vertex_const_handle     Vertex_const_handle;
-  typedef typename Ss::Halfedge_const_handle   Halfedge_const_handle;
   typedef typename Ss::Halfedge_const_iterator Halfedge_const_iterator;
 
-  Halfedge_const_handle null_halfedge;
-  Vertex_const_handle   null_vertex;
-
-  m_vertCount = iss->size_of_vertices();
-  m_edgeCount = iss->size_of_halfedges();
-  m_faceCount = iss->size_of_faces();
+  pOut->vertCount = iss->size_of_vertices();
+  pOut->edgeCount = iss->size_of_halfedges();
+  pOut->faceCount = iss->size_of_faces();
 
   for (Halfedge_const_iterator it = iss->halfedges_begin(); it != iss->halfedges_end(); ++it)
   {
     if (!it->is_bisector())
       continue;
 
+    // Both halfedges of a bisector are visited; only process one of them.
+    if (it->id() > it->opposite()->id())
+      continue;
+
+    // A bisector touches the boundary exactly when one of its ends is a contour vertex.
+    bool touchesBoundary = it->vertex()->is_contour() || it->opposite()->vertex()->is_contour();
+
     vec2 p0 = ToDgVec(it->opposite()->vertex()->point());
     vec2 p1 = ToDgVec(it->vertex()->point());
 
-    seg s(p0, p1);
-    bool intersectsBoundary = false;
-
-    for (auto it = polygon.loops.cbegin(); it != polygon.loops.cend(); it++)
+    if (validate)
     {
-      if (IntersectsBoundary(*it, s) == Dg::QueryCode::Intersecting)
+      seg s(p0, p1);
+      bool intersectsBoundary = false;
+
+      for (auto loop_it = polygon.loops.cbegin(); loop_it != polygon.loops.cend(); loop_it++)
       {
-        intersectsBoundary = true;
-        break;
+        if (IntersectsBoundary(*loop_it, s) == Dg::QueryCode::Intersecting)
+        {
+          intersectsBoundary = true;
+          break;
+        }
       }
+
+      if (intersectsBoundary != touchesBoundary)
+        pOut->mismatches++;
     }
-    if (intersectsBoundary)
-      m_boundaryConnections.push_back(seg(p0, p1));
+
+    if (touchesBoundary)
+      pOut->boundaryConnections.push_back(seg(p0, p1));
     else
-      m_segments.push_back(seg(p0, p1));
+      pOut->segments.push_back(seg(p0, p1));
+  }
+
+  pOut->skeleton = iss;
+}
+
+bool StraightSkeleton::SetGeometry(std::vector<PolygonLoop> const &loops)
+{
+  XN_TRACE_MODULE_SCOPE(m_frameTimes, "StraightSkeleton", "SetGeometry");
+  m_recorder.SetGeometry(loops);
+  Clear();
+
+  Common::ContentHash hash;
+  hash.AddLoops(m_simplifier.Run(loops));
+  hash.Add(m_validateBoundaryConnections);
+  hash.Add(m_checkIntersections);
+  m_resultKey = hash.Value();
+
+  bool success = false;
+  Common::CachedResult pResult = Common::ResultCache::Shared().Find(s_cacheCategory, m_resultKey);
+  if (pResult == nullptr || !ReadResult(*pResult, &success))
+  {
+    success = BuildSkeletons();
+    WriteResult(success);
   }
 
+  UpdateOffsets();
+  return success;
+}
+
+bool StraightSkeleton::BuildSkeletons()
+{
+  ClearSkeletons();
+
+  m_arena.Reset();
+  std::pmr::memory_resource *pScratch = m_arena.Resource();
+
+  // The arena only holds pointers into polygons; copying the regions themselves
+  // would still put their vertices on the heap.
+  auto polygons = BuildPolygonsWithHoles(m_simplifier.GetOutput());
+  std::pmr::vector<PolygonWithHoles const *> regions(pScratch);
+  regions.reserve(polygons.size());
+  for (auto const &polygon : polygons)
+    regions.push_back(&polygon);
+  if (regions.empty())
+    return true;
+
+  // One CGAL skeleton per region, each built from its own Polygon_with_holes.
+  std::pmr::vector<RegionResult> results(regions.size(), pScratch);
+  bool validate = m_validateBoundaryConnections;
+  bool checkIntersections = m_checkIntersections;
+  Common::ThreadPool::Shared().ParallelFor(regions.size(), [&](size_t i, uint32_t)
+  {
+    RegionResult &result = results[i];
+    result.vertCount = 0;
+    result.edgeCount = 0;
+    result.faceCount = 0;
+    result.mismatches = 0;
+    result.reoriented = 0;
+
+    // CGAL reports failed preconditions by throwing. Report them for the region
+    // rather than let them end the build.
+    try
+    {
+      BuildRegion(*regions[i], validate, checkIntersections, &result);
+    }
+    catch (std::exception const &e)
+    {
+      result = RegionResult();
+      result.error = e.what();
+    }
+  }, "StraightSkeleton");
+
+  // Merge in region order so the output does not depend on scheduling.
+  size_t failures = 0;
+  for (size_t i = 0; i < results.size(); i++)
+  {
+    RegionResult &result = results[i];
+    m_reorientedCount += result.reoriented;
+    if (!result.error.empty())
+    {
+      M_LOG_ERROR("Failed to create straight skeleton for region %u: %s", (uint32_t)i, result.error.c_str());
+      failures++;
+      continue;
+    }
+
+    if (result.mismatches != 0)
+      M_LOG_ERROR("Boundary connection validation failed for %u bisectors in region %u", (uint32_t)result.mismatches, (uint32_t)i);
+
+    if (result.skeleton != nullptr)
+      m_pimpl->skeletons.push_back(result.skeleton);
+
+    m_segments.insert(m_segments.end(), result.segments.begin(), result.segments.end());
+    m_boundaryConnections.insert(m_boundaryConnections.end(), result.boundaryConnections.begin(), result.boundaryConnections.end());
+    m_vertCount += result.vertCount;
+    m_edgeCount += result.edgeCount;
+    m_faceCount += result.faceCount;
+  }
+
+  return failures < results.size();
+}
+
+void StraightSkeleton::WriteResult(bool success)
+{
+  Common::ResultWriter writer;
+  writer.Write(success);
+  writer.Write<uint64_t>(m_pimpl->skeletons.size());
+  writer.Write<uint64_t>(m_vertCount);
+  writer.Write<uint64_t>(m_edgeCount);
+  writer.Write<uint64_t>(m_faceCount);
+  writer.Write<uint64_t>(m_reorientedCount);
+  writer.WriteSegments(m_segments);
+  writer.WriteSegments(m_boundaryConnections);
+  Common::ResultCache::Shared().Insert(s_cacheCategory, m_resultKey, std::move(writer.Data()));
+}
+
+bool StraightSkeleton::ReadResult(std::vector<uint8_t> const &data, bool *pSuccess)
+{
+  Common::ResultReader reader(data);
+  uint64_t counts[5] = {};
+  if (!reader.Read(pSuccess) || !reader.ReadBytes(counts, sizeof(counts)) ||
+      !reader.ReadSegments(&m_segments) || !reader.ReadSegments(&m_boundaryConnections))
+  {
+    ClearSkeletons();
+    return false;
+  }
+
+  m_skeletonsPending = counts[0] != 0;
+  m_vertCount = (size_t)counts[1];
+  m_edgeCount = (size_t)counts[2];
+  m_faceCount = (size_t)counts[3];
+  m_reorientedCount = (size_t)counts[4];
   return true;
 }
 
+uint64_t StraightSkeleton::OffsetKey(float distance) const
+{
+  Common::ContentHash hash(m_resultKey);
+  hash.Add(distance);
+  return hash.Value();
+}
+
+void StraightSkeleton::SetOffsets(std::vector<float> const &distances)
+{
+  // Only offsets whose distance changed are rebuilt, as when one is edited in the
+  // panel, so a replayed edit costs what the interactive one did.
+  size_t kept = std::min(m_offsets.size(), distances.size());
+  m_offsets.resize(distances.size(), Offset{});
+  for (size_t i = 0; i < distances.size(); i++)
+  {
+    Offset &offset = m_offsets[i];
+    if (i < kept && offset.distance == distances[i])
+      continue;
+    offset.distance = distances[i];
+    offset.dirty = true;
+  }
+  UpdateOffsets();
+}
+
+void StraightSkeleton::UpdateOffsets()
+{
+  if (m_pimpl->skeletons.empty() && !m_skeletonsPending)
+    return;
+
+  typedef std::chrono::high_resolution_clock Clock;
+  Common::ResultCache &cache = Common::ResultCache::Shared();
+  std::vector<Offset *> dirty;
+  for (auto &offset : m_offsets)
+  {
+    if (!offset.dirty)
+      continue;
+
+    Clock::time_point start = Clock::now();
+    Common::CachedResult pResult = cache.Find(s_cacheCategory, OffsetKey(offset.distance));
+    if (pResult != nullptr && Common::ResultReader(*pResult).ReadSegments(&offset.segments))
+    {
+      offset.dirty = false;
+      offset.ms = std::chrono::duration<float, std::milli>(Clock::now() - start).count();
+      continue;
+    }
+    dirty.push_back(&offset);
+  }
+
+  if (dirty.empty())
+    return;
+
+  // Results read from the cache come without the skeletons the offsets are built from.
+  if (m_skeletonsPending)
+    BuildSkeletons();
+
+  std::vector<SsPtr> const &skeletons = m_pimpl->skeletons;
+
+  // Offsets only read the skeletons, so every distance can be built at once.
+  std::vector<std::string> errors(dirty.size());
+  Common::ThreadPool::Shared().ParallelFor(dirty.size(), [&](size_t i, uint32_t)
+  {
+    XN_TRACE_SCOPE("StraightSkeleton", "Offset");
+    Clock::time_point start = Clock::now();
+
+    Offset *pOffset = dirty[i];
+    pOffset->segments.clear();
+    pOffset->dirty = false;
+
+    try
+    {
+      for (size_t r = 0; r < skeletons.size() && pOffset->distance > 0.f; r++)
+      {
+        auto contours = CGAL::create_offset_polygons_2<Polygon2>(K::FT(pOffset->distance), *skeletons[r], K());
+        for (auto const &contour : contours)
+        {
+          size_t size = contour->size();
+          for (size_t v = 0; v < size; v++)
+          {
+            vec2 p0 = ToDgVec((*contour)[v]);
+            vec2 p1 = ToDgVec((*contour)[(v + 1) % size]);
+            pOffset->segments.push_back(seg(p0, p1));
+          }
+        }
+      }
+    }
+    catch (std::exception const &e)
+    {
+      pOffset->segments.clear();
+      errors[i] = e.what();
+    }
+
+    pOffset->ms = std::chrono::duration<float, std::milli>(Clock::now() - start).count();
+  }, "StraightSkeleton");
+
+  // Failed offsets are logged and left out of the cache.
+  for (size_t i = 0; i < dirty.size(); i++)
+  {
+    Offset *pOffset = dirty[i];
+    if (!errors[i].empty())
+    {
+      M_LOG_ERROR("Failed to create offset %g: %s", pOffset->distance, errors[i].c_str());
+      continue;
+    }
+
+    Common::ResultWriter writer;
+    writer.WriteSegments(pOffset->segments);
+    cache.Insert(s_cacheCategory, OffsetKey(pOffset->distance), std::move(writer.Data()));
+  }
+}
+
+void StraightSkeleton::StartRecording()
+{
+  m_recorder.Start("StraightSkeleton", m_simplifier.GetInput());
+  m_recorder.AddSetting("simplify", Common::FormatValue(m_simplifier.GetTolerance()));
+  m_recorder.AddSetting("validate", Common::FormatValue(m_validateBoundaryConnections));
+  m_recorder.AddSetting("check", Common::FormatValue(m_checkIntersections));
+  m_recorder.AddSetting("offsets", Common::FormatValue(GetOffsetDistances()));
+}
+
+std::vector<float> StraightSkeleton::GetOffsetDistances() const
+{
+  std::vector<float> distances;
+  for (auto const &offset : m_offsets)
+    distances.push_back(offset.distance);
+  return distances;
+}
+
+void StraightSkeleton::DoOffsetFrame(UIContext *pContext)
+{
+  pContext->Checkbox("Show offsets##StraightSkeleton", &m_showOffsets);
+
+  bool changed = false;
+  for (size_t i = 0; i < m_offsets.size(); i++)
+  {
+    char label[64] = {};
+    snprintf(label, sizeof(label), "Offset %u##StraightSkeleton", (uint32_t)i);
+    if (pContext->InputFloat(label, &m_offsets[i].distance, 0.1f, 1.f))
+    {
+      m_offsets[i].dirty = true;
+      changed = true;
+    }
+    pContext->Text("%.3f ms, %u segments", m_offsets[i].ms, (uint32_t)m_offsets[i].segments.size());
+  }
+
+  if (pContext->Button("Add offset##StraightSkeleton"))
+  {
+    Offset offset = {};
+    offset.distance = m_offsets.empty() ? 1.f : m_offsets.back().distance * 2.f;
+    offset.dirty = true;
+    m_offsets.push_back(offset);
+    changed = true;
+  }
+
+  if (!m_offsets.empty() && pContext->Button("Remove offset##StraightSkeleton"))
+  {
+    m_offsets.pop_back();
+    m_recorder.ValueChanged("offsets", Common::FormatValue(GetOffsetDistances()));
+  }
+
+  if (changed)
+  {
+    m_recorder.ValueChanged("offsets", Common::FormatValue(GetOffsetDistances()));
+    UpdateOffsets();
+  }
+}
+
 void StraightSkeleton::_DoFrame(UIContext *pContext)
 {
+  XN_TRACE_MODULE_SCOPE(m_frameTimes, "StraightSkeleton", "_DoFrame");
+  Common::ModulePanel panel{"StraightSkeleton", &m_frameTimes, &m_simplifier, &m_arena, &m_recorder, s_cacheCategory,
+                            [this]() { StartRecording(); },
+                            [this]() { SetGeometry(m_simplifier.GetInput()); }};
+
   if (pContext->Button("What is this?##StraightSkeleton"))
     pContext->OpenPopup("Description##StraightSkeleton");
   if (pContext->BeginPopup("Description##StraightSkeleton"))
@@ -180,15 +581,39 @@ void StraightSkeleton::_DoFrame(UIContext *pContext)
     pContext->PopTextWrapPos();
     pContext->EndPopup();
   }
+  std::string error;
+  if (!Common::DoPanelHeader(pContext, panel, &error))
+    M_LOG_ERROR("%s", error.c_str());
+  pContext->Separator();
   pContext->Text("Vertices: %u", m_vertCount);
   pContext->Text("Edges: %u", m_edgeCount);
   pContext->Text("Faces: %u", m_faceCount);
+  pContext->Text("Reoriented loops: %u", (uint32_t)m_reorientedCount);
+  if (pContext->Checkbox("Check self-intersections##StraightSkeleton", &m_checkIntersections))
+    m_recorder.ValueChanged("check", Common::FormatValue(m_checkIntersections));
   pContext->Checkbox("Show boundary connections##StraightSkeleton", &m_showBoundaryConnections);
+  if (pContext->Checkbox("Validate boundary connections##StraightSkeleton", &m_validateBoundaryConnections))
+    m_recorder.ValueChanged("validate", Common::FormatValue(m_validateBoundaryConnections));
+  pContext->Separator();
+  Common::DoSimplifyControls(pContext, panel);
+  pContext->Separator();
+  DoOffsetFrame(pContext);
 }
 
+// Drawn straight from the segment arrays, not through a Common::DrawStore. They are
+// already in the form DrawLineGroup takes and are rebuilt only when the result
+// changes, and the result cache reads and writes them, so a store would hold a
+// second copy and save no work.
 void StraightSkeleton::Render(IRenderer *pRenderer)
 {
+  XN_TRACE_MODULE_SCOPE(m_frameTimes, "StraightSkeleton", "Render");
   pRenderer->DrawLineGroup(m_segments.data(), m_segments.size(), 2, 0xFFFFFF00, 0);
   if (m_showBoundaryConnections)
     pRenderer->DrawLineGroup(m_boundaryConnections.data(), m_boundaryConnections.size(), 2, 0xFFFFFF00, 0);
+
+  if (m_showOffsets)
+  {
+    for (auto const &offset : m_offsets)
+      pRenderer->DrawLineGroup(offset.segments.data(), offset.segments.size(), 2, 0xFF00FFFF, 0);
+  }
 }
\ No newline at end of file
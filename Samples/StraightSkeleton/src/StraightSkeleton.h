@@ -10,19 +10,78 @@
 #include "xnIRenderer.h"
 #include "xnLogger.h"
 
+#include "Arena.h"
+#include "InputRecord.h"
+#include "ModulePanel.h"
+#include "ResultCache.h"
+#include "Simplify.h"
+#include "Trace.h"
+
 class StraightSkeleton : public xn::Module
 {
 public:
 
   StraightSkeleton(xn::ModuleInitData *);
+  ~StraightSkeleton();
+
+  StraightSkeleton(StraightSkeleton const &) = delete;
+  StraightSkeleton &operator=(StraightSkeleton const &) = delete;
 
   void Clear();
   bool SetGeometry(std::vector<xn::PolygonLoop> const &) override;
   void Render(xn::IRenderer *) override;
 
+  // Parameters and results, for driving the module without the UI.
+  void SetValidateBoundaryConnections(bool validate) { m_validateBoundaryConnections = validate; }
+  void SetCheckIntersections(bool check) { m_checkIntersections = check; }
+  void SetOffsets(std::vector<float> const &distances);
+  Common::Simplifier &GetSimplifier() { return m_simplifier; }
+  Common::Arena const &GetArena() const { return m_arena; }
+
+  size_t GetVertexCount() const { return m_vertCount; }
+  size_t GetEdgeCount() const { return m_edgeCount; }
+  size_t GetFaceCount() const { return m_faceCount; }
+  size_t GetSegmentCount() const { return m_segments.size(); }
+  size_t GetReorientedCount() const { return m_reorientedCount; }
+  size_t GetOffsetCount() const { return m_offsets.size(); }
+  float GetOffsetDistance(size_t index) const { return m_offsets[index].distance; }
+  float GetOffsetMs(size_t index) const { return m_offsets[index].ms; }
+  size_t GetOffsetSegmentCount(size_t index) const { return m_offsets[index].segments.size(); }
+
 private:
 
   void _DoFrame(xn::UIContext *) override;
+  void DoOffsetFrame(xn::UIContext *);
+  void StartRecording();
+  std::vector<float> GetOffsetDistances() const;
+  void ClearSkeletons();
+  bool BuildSkeletons();
+  void UpdateOffsets();
+
+  // The skeleton result and each offset are cached apart, so changing an offset
+  // does not store the skeleton again.
+  void WriteResult(bool success);
+  bool ReadResult(std::vector<uint8_t> const &data, bool *pSuccess);
+  uint64_t OffsetKey(float distance) const;
+
+  // Inset contours at one distance, generated from the cached skeleton.
+  struct Offset
+  {
+    float distance;
+    float ms;
+    bool dirty;
+    std::vector<xn::seg> segments;
+  };
+
+  class PIMPL;
+  PIMPL *m_pimpl;
+  Common::Simplifier m_simplifier;
+  Common::Arena m_arena;
+  Common::InputRecorder m_recorder;
+  Common::FrameTimes m_frameTimes;
+
+  std::vector<Offset> m_offsets;
+  bool m_showOffsets;
 
   std::vector<xn::seg> m_segments;
   std::vector<xn::seg> m_boundaryConnections;
@@ -31,6 +90,12 @@ private:
   size_t m_faceCount;
 
   bool m_showBoundaryConnections;
+  bool m_validateBoundaryConnections;
+  bool m_checkIntersections;
+  size_t m_reorientedCount;
+
+  uint64_t m_resultKey;
+  bool m_skeletonsPending; // Results came from the cache; skeletons are built when an offset needs them
 };
 
 #endif
\ No newline at end of file
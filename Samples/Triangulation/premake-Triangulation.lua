@@ -64,6 +64,7 @@ project "Triangulation"
     vcpkgPackageDir .. "/boost-multi-index_x64-windows/include",
     vcpkgPackageDir .. "/boost-optional_x64-windows/include",
     "src",
+    "%{wks.location}/Common/src",
     "%{wks.location}/XornCore/src",
     "%{wks.location}/DgLib/src"
   }
@@ -72,12 +73,14 @@ project "Triangulation"
   {
     vcpkgPackageDir .. "/gmp_x64-windows/lib/gmp.lib",
     "DgLib",
-	"XornCore"
+	"XornCore",
+	"Common"
   }
   
   postbuildcommands 
   {
     "{COPY} %{wks.location}/build/%{prj.name}-%{cfg.buildcfg}/Triangulation.dll %{wks.location}/XornApp/Plugins/Triangulation",
+    "{COPY} %{wks.location}/build/Common-%{cfg.buildcfg}/Common.dll %{wks.location}/XornApp/Plugins/Triangulation",
 	"{COPY} " .. vcpkgPackageDir .. "/gmp_x64-windows/bin/gmp-10.dll %{wks.location}/XornApp/Plugins/Triangulation"
   }
 	
@@ -0,0 +1,165 @@
+
+#include <cmath>
+#include <cfloat>
+#include <algorithm>
+
+#include "EdgeLods.h"
+
+using namespace xn;
+
+static uint32_t const s_edgesPerTile = 1024;
+static uint32_t const s_maxTilesPerSide = 128;
+static int const s_maxLods = 5;
+static float const s_lodScale = 4.f;
+
+static void GetBounds(std::vector<LodEdge> const &edges, vec2 *pMin, vec2 *pMax)
+{
+  vec2 minBounds(FLT_MAX, FLT_MAX);
+  vec2 maxBounds(-FLT_MAX, -FLT_MAX);
+  for (auto const &edge : edges)
+  {
+    for (int a = 0; a < 2; a++)
+    {
+      minBounds[a] = std::min(minBounds[a], std::min(edge.p0[a], edge.p1[a]));
+      maxBounds[a] = std::max(maxBounds[a], std::max(edge.p0[a], edge.p1[a]));
+    }
+  }
+  *pMin = minBounds;
+  *pMax = maxBounds;
+}
+
+// Snap end points to the centre of their cluster cell and keep one copy of each
+// edge that still has length.
+static std::vector<LodEdge> ClusterEdges(std::vector<LodEdge> const &edges, float clusterSize)
+{
+  struct Key
+  {
+    int32_t c[4];
+    bool operator<(Key const &o) const { return std::lexicographical_compare(c, c + 4, o.c, o.c + 4); }
+    bool operator==(Key const &o) const { return std::equal(c, c + 4, o.c); }
+  };
+
+  vec2 minBounds, maxBounds;
+  GetBounds(edges, &minBounds, &maxBounds);
+  float invSize = 1.f / clusterSize;
+
+  std::vector<Key> keys;
+  keys.reserve(edges.size());
+  for (auto const &edge : edges)
+  {
+    int32_t x0 = (int32_t)((edge.p0.x() - minBounds.x()) * invSize);
+    int32_t y0 = (int32_t)((edge.p0.y() - minBounds.y()) * invSize);
+    int32_t x1 = (int32_t)((edge.p1.x() - minBounds.x()) * invSize);
+    int32_t y1 = (int32_t)((edge.p1.y() - minBounds.y()) * invSize);
+    if (x0 == x1 && y0 == y1)
+      continue;
+
+    Key key = {{x0, y0, x1, y1}};
+    if (x1 < x0 || (x1 == x0 && y1 < y0))
+      key = {{x1, y1, x0, y0}};
+    keys.push_back(key);
+  }
+
+  std::sort(keys.begin(), keys.end());
+  keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+
+  std::vector<LodEdge> result;
+  result.reserve(keys.size());
+  for (auto const &key : keys)
+  {
+    LodEdge edge;
+    edge.p0 = vec2(minBounds.x() + ((float)key.c[0] + 0.5f) * clusterSize, minBounds.y() + ((float)key.c[1] + 0.5f) * clusterSize);
+    edge.p1 = vec2(minBounds.x() + ((float)key.c[2] + 0.5f) * clusterSize, minBounds.y() + ((float)key.c[3] + 0.5f) * clusterSize);
+    result.push_back(edge);
+  }
+  return result;
+}
+
+static void BuildTiles(std::vector<LodEdge> const &edges, float clusterSize, EdgeLod *pLod)
+{
+  pLod->clusterSize = clusterSize;
+  pLod->edges.clear();
+  pLod->tiles.clear();
+  GetBounds(edges, &pLod->minBounds, &pLod->maxBounds);
+
+  if (edges.empty())
+    return;
+
+  uint32_t tilesPerSide = (uint32_t)std::ceil(std::sqrt((float)edges.size() / (float)s_edgesPerTile));
+  tilesPerSide = std::max(1u, std::min(tilesPerSide, s_maxTilesPerSide));
+
+  vec2 minBounds = pLod->minBounds;
+  vec2 range = pLod->maxBounds - minBounds;
+  vec2 invTileSize(range.x() > 0.f ? (float)tilesPerSide / range.x() : 0.f,
+                   range.y() > 0.f ? (float)tilesPerSide / range.y() : 0.f);
+
+  std::vector<uint32_t> edgeTiles(edges.size());
+  std::vector<uint32_t> counts((size_t)tilesPerSide * tilesPerSide, 0);
+  for (size_t i = 0; i < edges.size(); i++)
+  {
+    vec2 mid = (edges[i].p0 + edges[i].p1) * 0.5f;
+    uint32_t x = std::min((uint32_t)((mid.x() - minBounds.x()) * invTileSize.x()), tilesPerSide - 1);
+    uint32_t y = std::min((uint32_t)((mid.y() - minBounds.y()) * invTileSize.y()), tilesPerSide - 1);
+    edgeTiles[i] = y * tilesPerSide + x;
+    counts[edgeTiles[i]]++;
+  }
+
+  pLod->tiles.resize(counts.size());
+  uint32_t offset = 0;
+  for (size_t t = 0; t < counts.size(); t++)
+  {
+    EdgeTile &tile = pLod->tiles[t];
+    tile.minBounds = vec2(FLT_MAX, FLT_MAX);
+    tile.maxBounds = vec2(-FLT_MAX, -FLT_MAX);
+    tile.begin = offset;
+    tile.count = 0;
+    offset += counts[t];
+  }
+
+  pLod->edges.resize(edges.size());
+  for (size_t i = 0; i < edges.size(); i++)
+  {
+    EdgeTile &tile = pLod->tiles[edgeTiles[i]];
+    pLod->edges[tile.begin + tile.count] = seg(edges[i].p0, edges[i].p1);
+    tile.count++;
+
+    for (int a = 0; a < 2; a++)
+    {
+      tile.minBounds[a] = std::min(tile.minBounds[a], std::min(edges[i].p0[a], edges[i].p1[a]));
+      tile.maxBounds[a] = std::max(tile.maxBounds[a], std::max(edges[i].p0[a], edges[i].p1[a]));
+    }
+  }
+}
+
+void BuildEdgeLods(std::vector<LodEdge> const &edges, std::vector<EdgeLod> *pLods)
+{
+  pLods->clear();
+  pLods->resize(1);
+  BuildTiles(edges, 0.f, &(*pLods)[0]);
+
+  if (edges.empty())
+    return;
+
+  double totalLength = 0.0;
+  for (auto const &edge : edges)
+  {
+    vec2 v = edge.p1 - edge.p0;
+    totalLength += std::sqrt((double)v.x() * v.x() + (double)v.y() * v.y());
+  }
+
+  float clusterSize = (float)(totalLength / (double)edges.size()) * s_lodScale;
+  std::vector<LodEdge> current = edges;
+  for (int level = 1; level < s_maxLods && clusterSize > 0.f; level++)
+  {
+    std::vector<LodEdge> coarse = ClusterEdges(edges, clusterSize);
+
+    // Stop once a level no longer removes a meaningful share of the edges.
+    if (coarse.empty() || coarse.size() * 2 > current.size())
+      break;
+
+    pLods->push_back(EdgeLod());
+    BuildTiles(coarse, clusterSize, &pLods->back());
+    current = std::move(coarse);
+    clusterSize *= s_lodScale;
+  }
+}
\ No newline at end of file
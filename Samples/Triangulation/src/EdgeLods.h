@@ -0,0 +1,43 @@
+#ifndef EDGELODS_H
+#define EDGELODS_H
+
+#include <stdint.h>
+#include <vector>
+
+#include "xnCommon.h"
+
+struct LodEdge
+{
+  xn::vec2 p0;
+  xn::vec2 p1;
+};
+
+// A cell of the grid the edges of a level are bucketed into, by midpoint. The
+// bounds cover the tile's edges, which may reach past the cell.
+struct EdgeTile
+{
+  xn::vec2 minBounds;
+  xn::vec2 maxBounds;
+  uint32_t begin;
+  uint32_t count;
+};
+
+// One level of detail of the mesh edges. A non-zero cluster size marks a coarse
+// level, built by snapping edge end points to a grid of that size and dropping the
+// edges that collapse. Edges are stored tile by tile and tiles row by row, so the
+// edges of a run of tiles in a row are contiguous and can be drawn in one call.
+struct EdgeLod
+{
+  float clusterSize;
+  xn::vec2 minBounds;
+  xn::vec2 maxBounds;
+  std::vector<xn::seg> edges;
+  std::vector<EdgeTile> tiles;
+};
+
+// Builds the full detail level followed by progressively coarser levels, each with
+// at most half the edges of the one before. The number of levels is capped, so the
+// coarsest level can still be large.
+void BuildEdgeLods(std::vector<LodEdge> const &edges, std::vector<EdgeLod> *pLods);
+
+#endif
\ No newline at end of file
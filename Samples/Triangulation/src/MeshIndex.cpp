@@ -0,0 +1,215 @@
+
+#include <cmath>
+#include <cfloat>
+#include <algorithm>
+
+#include "MeshIndex.h"
+
+using namespace xn;
+
+uint32_t const MeshIndex::InvalidIndex = 0xFFFFFFFF;
+
+// Twice the signed area of the triangle (a, b, p); positive if p lies left of a->b.
+static double Orient(vec2 const &a, vec2 const &b, vec2 const &p)
+{
+  return ((double)b.x() - a.x()) * ((double)p.y() - a.y()) - ((double)b.y() - a.y()) * ((double)p.x() - a.x());
+}
+
+MeshIndex::MeshIndex()
+  : m_vertices()
+  , m_triangles()
+  , m_seeds()
+  , m_gridOrigin(0.f, 0.f)
+  , m_invCellSize(1.f)
+  , m_gridWidth(0)
+  , m_gridHeight(0)
+{
+
+}
+
+void MeshIndex::Clear()
+{
+  m_vertices.clear();
+  m_triangles.clear();
+  m_seeds.clear();
+  m_gridWidth = 0;
+  m_gridHeight = 0;
+}
+
+void MeshIndex::Build(std::vector<vec2> &&vertices, std::vector<Triangle> &&triangles)
+{
+  m_vertices = std::move(vertices);
+  m_triangles = std::move(triangles);
+  BuildGrid();
+}
+
+void MeshIndex::BuildGrid()
+{
+  m_seeds.clear();
+  m_gridWidth = 0;
+  m_gridHeight = 0;
+
+  if (m_triangles.empty())
+    return;
+
+  vec2 minBounds(FLT_MAX, FLT_MAX);
+  vec2 maxBounds(-FLT_MAX, -FLT_MAX);
+  for (auto const &v : m_vertices)
+  {
+    for (int a = 0; a < 2; a++)
+    {
+      if (v[a] < minBounds[a]) minBounds[a] = v[a];
+      if (v[a] > maxBounds[a]) maxBounds[a] = v[a];
+    }
+  }
+
+  // Aim for a handful of triangles per cell.
+  vec2 range = maxBounds - minBounds;
+  float area = std::max(range.x() * range.y(), FLT_MIN);
+  float cellCount = std::max(1.f, (float)m_triangles.size() / 4.f);
+  float cellSize = std::sqrt(area / cellCount);
+  if (cellSize <= 0.f)
+    cellSize = std::max(std::max(range.x(), range.y()), 1.f);
+
+  m_gridOrigin = minBounds;
+  m_invCellSize = 1.f / cellSize;
+  m_gridWidth = std::max(1u, (uint32_t)(range.x() * m_invCellSize) + 1);
+  m_gridHeight = std::max(1u, (uint32_t)(range.y() * m_invCellSize) + 1);
+  m_seeds.assign((size_t)m_gridWidth * m_gridHeight, InvalidIndex);
+
+  // Seed each cell with a triangle whose centroid falls inside it.
+  std::vector<uint32_t> frontier;
+  for (uint32_t t = 0; t < (uint32_t)m_triangles.size(); t++)
+  {
+    Triangle const &tri = m_triangles[t];
+    vec2 centroid = (m_vertices[tri.vertices[0]] + m_vertices[tri.vertices[1]] + m_vertices[tri.vertices[2]]) * (1.f / 3.f);
+    uint32_t cell = CellIndex(centroid);
+    if (m_seeds[cell] == InvalidIndex)
+    {
+      m_seeds[cell] = t;
+      frontier.push_back(cell);
+    }
+  }
+
+  // Flood the remaining empty cells from their seeded neighbours.
+  for (size_t i = 0; i < frontier.size(); i++)
+  {
+    uint32_t cell = frontier[i];
+    uint32_t x = cell % m_gridWidth;
+    uint32_t y = cell / m_gridWidth;
+
+    uint32_t neighbours[4];
+    int count = 0;
+    if (x > 0) neighbours[count++] = cell - 1;
+    if (x + 1 < m_gridWidth) neighbours[count++] = cell + 1;
+    if (y > 0) neighbours[count++] = cell - m_gridWidth;
+    if (y + 1 < m_gridHeight) neighbours[count++] = cell + m_gridWidth;
+
+    for (int n = 0; n < count; n++)
+    {
+      if (m_seeds[neighbours[n]] != InvalidIndex)
+        continue;
+      m_seeds[neighbours[n]] = m_seeds[cell];
+      frontier.push_back(neighbours[n]);
+    }
+  }
+}
+
+uint32_t MeshIndex::CellIndex(vec2 const &point) const
+{
+  float fx = (point.x() - m_gridOrigin.x()) * m_invCellSize;
+  float fy = (point.y() - m_gridOrigin.y()) * m_invCellSize;
+  uint32_t x = fx <= 0.f ? 0 : std::min((uint32_t)fx, m_gridWidth - 1);
+  uint32_t y = fy <= 0.f ? 0 : std::min((uint32_t)fy, m_gridHeight - 1);
+  return y * m_gridWidth + x;
+}
+
+bool MeshIndex::Contains(uint32_t triangle, vec2 const &point, float *pWeights) const
+{
+  Triangle const &tri = m_triangles[triangle];
+  vec2 const &v0 = m_vertices[tri.vertices[0]];
+  vec2 const &v1 = m_vertices[tri.vertices[1]];
+  vec2 const &v2 = m_vertices[tri.vertices[2]];
+
+  double w0 = Orient(v1, v2, point);
+  double w1 = Orient(v2, v0, point);
+  double w2 = Orient(v0, v1, point);
+  if (w0 < 0.0 || w1 < 0.0 || w2 < 0.0)
+    return false;
+
+  double sum = w0 + w1 + w2;
+  if (sum <= 0.0)
+    return false;
+
+  pWeights[0] = (float)(w0 / sum);
+  pWeights[1] = (float)(w1 / sum);
+  pWeights[2] = (float)(w2 / sum);
+  return true;
+}
+
+uint32_t MeshIndex::Walk(uint32_t start, vec2 const &point, float *pWeights) const
+{
+  uint32_t current = start;
+  size_t maxSteps = m_triangles.size();
+
+  for (size_t step = 0; step < maxSteps; step++)
+  {
+    Triangle const &tri = m_triangles[current];
+
+    // Rotate the first edge tested each step so the walk cannot cycle.
+    uint32_t next = current;
+    for (int k = 0; k < 3; k++)
+    {
+      int i = (int)((k + step) % 3);
+      vec2 const &a = m_vertices[tri.vertices[(i + 1) % 3]];
+      vec2 const &b = m_vertices[tri.vertices[(i + 2) % 3]];
+      if (Orient(a, b, point) < 0.0)
+      {
+        next = tri.neighbours[i];
+        break;
+      }
+    }
+
+    if (next == InvalidIndex)
+      return InvalidIndex; // Walked off the hull of the mesh
+
+    if (next == current)
+    {
+      if (Contains(current, point, pWeights))
+        return current;
+      break; // Degenerate triangle, fall back to a scan
+    }
+
+    current = next;
+  }
+
+  return Scan(point, pWeights);
+}
+
+uint32_t MeshIndex::Scan(vec2 const &point, float *pWeights) const
+{
+  for (uint32_t t = 0; t < (uint32_t)m_triangles.size(); t++)
+  {
+    if (Contains(t, point, pWeights))
+      return t;
+  }
+  return InvalidIndex;
+}
+
+MeshIndex::Location MeshIndex::Locate(vec2 const &point) const
+{
+  Location result = {InvalidIndex, {0.f, 0.f, 0.f}};
+  if (m_seeds.empty())
+    return result;
+
+  uint32_t triangle = Walk(m_seeds[CellIndex(point)], point, result.weights);
+  if (triangle != InvalidIndex && m_triangles[triangle].inDomain)
+    result.triangle = triangle;
+  return result;
+}
+
+void MeshIndex::Locate(vec2 const *pPoints, size_t count, Location *pOut) const
+{
+  for (size_t i = 0; i < count; i++)
+    pOut[i] = Locate(pPoints[i]);
+}
\ No newline at end of file
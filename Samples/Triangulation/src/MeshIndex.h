@@ -0,0 +1,66 @@
+#ifndef MESHINDEX_H
+#define MESHINDEX_H
+
+#include <stdint.h>
+#include <vector>
+
+#include "xnCommon.h"
+
+// Compact triangle adjacency over a generated mesh, with point-location queries.
+// Queries start from a seed triangle cached in a uniform grid (jump) and then walk
+// across the adjacency to the containing triangle (walk). All queries are const and
+// touch no shared mutable state, so any number of threads may query at once, as
+// long as no thread is rebuilding the index at the same time.
+class MeshIndex
+{
+public:
+
+  static uint32_t const InvalidIndex;
+
+  struct Triangle
+  {
+    uint32_t vertices[3];   // Counter-clockwise
+    uint32_t neighbours[3]; // neighbours[i] is the triangle opposite vertices[i]
+    bool inDomain;
+  };
+
+  struct Location
+  {
+    uint32_t triangle;  // InvalidIndex if the point is not inside the meshed domain
+    float weights[3];   // Barycentric weights of the triangle vertices
+  };
+
+  MeshIndex();
+
+  void Clear();
+  void Build(std::vector<xn::vec2> &&vertices, std::vector<Triangle> &&triangles);
+
+  Location Locate(xn::vec2 const &point) const;
+  void Locate(xn::vec2 const *pPoints, size_t count, Location *pOut) const;
+
+  size_t VertexCount() const { return m_vertices.size(); }
+  size_t TriangleCount() const { return m_triangles.size(); }
+  xn::vec2 const &GetVertex(uint32_t index) const { return m_vertices[index]; }
+  Triangle const &GetTriangle(uint32_t index) const { return m_triangles[index]; }
+
+private:
+
+  void BuildGrid();
+  uint32_t CellIndex(xn::vec2 const &point) const;
+  bool Contains(uint32_t triangle, xn::vec2 const &point, float *pWeights) const;
+  uint32_t Walk(uint32_t start, xn::vec2 const &point, float *pWeights) const;
+  uint32_t Scan(xn::vec2 const &point, float *pWeights) const;
+
+private:
+
+  std::vector<xn::vec2> m_vertices;
+  std::vector<Triangle> m_triangles;
+
+  std::vector<uint32_t> m_seeds;
+  xn::vec2 m_gridOrigin;
+  float m_invCellSize;
+  uint32_t m_gridWidth;
+  uint32_t m_gridHeight;
+};
+
+#endif
\ No newline at end of file
@@ -1,7 +1,10 @@
 
 #include <algorithm>
+#ifndef XN_HEADLESS
 #include <windows.h>
+#endif
 #include <vector>
+#include <numeric>
 
 #include <CGAL/Exact_predicates_inexact_constructions_kernel.h>
 #include <CGAL/Constrained_Delaunay_triangulation_2.h>
@@ -10,9 +13,15 @@
 #include <CGAL/Delaunay_mesh_vertex_base_2.h>
 #include <CGAL/Delaunay_mesh_size_criteria_2.h>
 #include <CGAL/lloyd_optimize_mesh_2.h>
+#include <CGAL/spatial_sort.h>
+#include <CGAL/Spatial_sort_traits_adapter_2.h>
+#include <CGAL/property_map.h>
+#include <CGAL/Unique_hash_map.h>
 
 #include "Triangulation.h"
+#ifndef XN_HEADLESS
 #include "xnPluginAPI.h"
+#endif
 #include "xnVersion.h"
 #include "xnLogger.h"
 
@@ -24,15 +33,18 @@ typedef CGAL::Constrained_Delaunay_triangulation_2<K, Tds>  CDT;
 typedef CGAL::Delaunay_mesh_size_criteria_2<CDT>            Criteria;
 typedef CGAL::Delaunay_mesher_2<CDT, Criteria>              Mesher;
 typedef CDT::Vertex_handle Vertex_handle;
+typedef CDT::Face_handle Face_handle;
 typedef CDT::Point Point;
+typedef CGAL::Spatial_sort_traits_adapter_2<K, CGAL::Pointer_property_map<Point>::type> SortTraits;
 
 using namespace xn;
 
+Dg::ErrorCode ConvexPartition(DgPolygon const &, std::vector<xn::PolygonLoop> *pOut);
+
+#ifndef XN_HEADLESS
 DEFINE_STANDARD_EXPORTS
 DEFINE_DLLMAIN
 
-Dg::ErrorCode ConvexPartition(DgPolygon const &, std::vector<xn::PolygonLoop> *pOut);
-
 Module * xnPlugin_CreateModule(xn::ModuleInitData *pData)
 {
   return new Triangulation(pData);
@@ -42,6 +54,61 @@ char const *xnPlugin_GetModuleName()
 {
   return "Triangulation";
 }
+#endif
+
+static char const *s_stageNames[] =
+{
+  "Value bounds",
+  "Seeds",
+  "Constraints",
+  "Refine mesh",
+  "Lloyd",
+  "Index",
+  "Faces",
+  "Edges",
+  "LODs"
+};
+
+static char const *s_cacheCategory = "Triangulation";
+
+// Default for the most edges Render submits per frame.
+static size_t const s_defaultMaxDrawnEdges = 1000000;
+
+// Use a coarser level once its cluster cells are no bigger than this many pixels.
+static float const s_lodPixelThreshold = 2.f;
+
+// Assumed width of the view in pixels, as IRenderer does not report the window size.
+static float const s_viewPixels = 1024.f;
+static float const s_maxViewZoom = 1000.f;
+
+// Times consecutive stages. Each stage is also recorded as a trace span.
+class StageTimer
+{
+public:
+
+  StageTimer()
+    : m_lap(Common::TraceTime())
+  {
+
+  }
+
+  // Returns the milliseconds elapsed since the last call.
+  float Lap(int stage)
+  {
+    uint64_t now = Common::TraceTime();
+#ifndef XN_NO_TRACE
+    if (Common::IsTracing())
+      Common::RecordTrace("Triangulation", s_stageNames[stage], m_lap, now);
+#endif
+    float ms = (float)(now - m_lap) * 1.e-6f;
+    m_lap = now;
+    return ms;
+  }
+
+private:
+
+  uint64_t m_lap;
+};
 
 template<typename T>
 static vec2 ToDgVec(T const &p)
@@ -49,6 +116,41 @@ static vec2 ToDgVec(T const &p)
   return vec2((float)p.x(), (float)p.y());
 }
 
+static void BuildMeshIndex(CDT const &cdt, MeshIndex *pIndex)
+{
+  CGAL::Unique_hash_map<CDT::Vertex_handle, uint32_t> vertexIndices(MeshIndex::InvalidIndex, cdt.number_of_vertices());
+  CGAL::Unique_hash_map<CDT::Face_handle, uint32_t> faceIndices(MeshIndex::InvalidIndex, cdt.number_of_faces());
+
+  std::vector<vec2> vertices;
+  vertices.reserve(cdt.number_of_vertices());
+  for (auto it = cdt.finite_vertices_begin(); it != cdt.finite_vertices_end(); it++)
+  {
+    vertexIndices[it] = (uint32_t)vertices.size();
+    vertices.push_back(ToDgVec(it->point()));
+  }
+
+  uint32_t faceCount = 0;
+  for (auto it = cdt.finite_faces_begin(); it != cdt.finite_faces_end(); it++)
+    faceIndices[it] = faceCount++;
+
+  std::vector<MeshIndex::Triangle> triangles;
+  triangles.reserve(faceCount);
+  for (auto it = cdt.finite_faces_begin(); it != cdt.finite_faces_end(); it++)
+  {
+    MeshIndex::Triangle tri;
+    for (int i = 0; i < 3; i++)
+    {
+      tri.vertices[i] = vertexIndices[it->vertex(i)];
+      CDT::Face_handle neighbour = it->neighbor(i);
+      tri.neighbours[i] = cdt.is_infinite(neighbour) ? MeshIndex::InvalidIndex : faceIndices[neighbour];
+    }
+    tri.inDomain = it->is_in_domain();
+    triangles.push_back(tri);
+  }
+
+  pIndex->Build(std::move(vertices), std::move(triangles));
+}
+
 static std::vector<Point> GenerateSeeds(PolygonWithHoles const &polygon)
 {
   std::vector<Point> result;
@@ -113,9 +215,24 @@ bool Triangulation::UniqueEdge::operator<(UniqueEdge const &a) const
 
 Triangulation::Triangulation(xn::ModuleInitData *pData)
   : Module(pData)
+  , m_frameTimes()
+  , m_simplifier()
+  , m_arena()
+  , m_recorder()
   , m_edgeSet()
+  , m_viewCentre(0.f, 0.f)
+  , m_viewZoom(1.f)
+  , m_mouseDown(false)
+  , m_maxDrawnEdges(s_defaultMaxDrawnEdges)
+  , m_drawnEdges(0)
+  , m_drawnLod(0)
   , m_vertCount(0)
   , m_faceCount(0)
+  , m_domainFaceCount(0)
+  , m_fromCache(false)
+  , m_timings{}
+  , m_timingIndex(0)
+  , m_timingCount(0)
   , m_sizeCriteriaBounds(1.f, 1.f)
   , m_sizeCriteria(1.f)
   , m_shapeCriteria(0.125f)
@@ -128,8 +245,45 @@ Triangulation::Triangulation(xn::ModuleInitData *pData)
 void Triangulation::Clear()
 {
   m_edgeSet.clear();
+  m_edgeLods.clear();
+  m_meshIndex.Clear();
   m_vertCount = 0;
   m_faceCount = 0;
+  m_domainFaceCount = 0;
+  m_fromCache = false;
+}
+
+void Triangulation::RecordTimings(float const (&stageTimes)[StageCount])
+{
+  for (int i = 0; i < StageCount; i++)
+    m_timings[i][m_timingIndex] = stageTimes[i];
+
+  m_timingIndex = (m_timingIndex + 1) % s_timingHistorySize;
+  if (m_timingCount < s_timingHistorySize)
+    m_timingCount++;
+}
+
+char const *Triangulation::GetStageName(int stage)
+{
+  return s_stageNames[stage];
+}
+
+float Triangulation::GetLastTiming(int stage) const
+{
+  if (m_timingCount == 0)
+    return 0.f;
+  return m_timings[stage][(m_timingIndex + s_timingHistorySize - 1) % s_timingHistorySize];
+}
+
+float Triangulation::AverageTiming(int stage) const
+{
+  if (m_timingCount == 0)
+    return 0.f;
+
+  float sum = 0.f;
+  for (int i = 0; i < m_timingCount; i++)
+    sum += m_timings[stage][i];
+  return sum / (float)m_timingCount;
 }
 
 void Triangulation::SetValueBounds()
@@ -137,6 +291,10 @@ void Triangulation::SetValueBounds()
   float const divisorMin = 20.f;
   float const divisorMax = 5.f;
 
+  // Nothing to bound, eg every loop was simplified away. The old bounds are kept.
+  if (m_polygon.loops.empty())
+    return;
+
   vec2 minBounds(FLT_MAX, FLT_MAX);
   vec2 maxBounds(-FLT_MAX, -FLT_MAX);
 
@@ -152,7 +310,7 @@ void Triangulation::SetValueBounds()
   }
 
   vec2 range = maxBounds - minBounds;
-  float maxDimension = max(range.x(), range.y());
+  float maxDimension = std::max(range.x(), range.y());
   m_sizeCriteriaBounds.x() = maxDimension / divisorMin;
   m_sizeCriteriaBounds.y() = maxDimension / divisorMax;
 
@@ -160,51 +318,154 @@ void Triangulation::SetValueBounds()
     m_sizeCriteria = (m_sizeCriteriaBounds.x() + m_sizeCriteriaBounds.y()) / 2.f;
 }
 
+void Triangulation::MouseDown(uint32_t modState, vec2 const &p)
+{
+  XN_TRACE_MODULE_SCOPE(m_frameTimes, "Triangulation", "MouseDown");
+  m_recorder.MouseDown(modState, p);
+  m_viewCentre = p;
+  m_mouseDown = true;
+}
+
+void Triangulation::MouseUp(uint32_t modState)
+{
+  XN_TRACE_MODULE_SCOPE(m_frameTimes, "Triangulation", "MouseUp");
+  m_recorder.MouseUp(modState);
+  m_mouseDown = false;
+}
+
+void Triangulation::MouseMove(uint32_t modState, vec2 const &p)
+{
+  XN_TRACE_MODULE_SCOPE(m_frameTimes, "Triangulation", "MouseMove");
+  m_recorder.MouseMove(modState, p);
+  if (m_mouseDown)
+    m_viewCentre = p;
+}
+
+void Triangulation::SetView(vec2 const &centre, float zoom)
+{
+  m_viewCentre = centre;
+  m_viewZoom = std::min(std::max(zoom, 1.f), s_maxViewZoom);
+}
+
 bool Triangulation::SetGeometry(std::vector<xn::PolygonLoop> const &loops)
 {
-  auto polygons = xn::BuildPolygonsWithHoles(loops);
+  XN_TRACE_MODULE_SCOPE(m_frameTimes, "Triangulation", "SetGeometry");
+  m_recorder.SetGeometry(loops);
+  auto polygons = xn::BuildPolygonsWithHoles(m_simplifier.Run(loops));
 
   if (polygons.empty())
     m_polygon.loops.clear();
   else
     m_polygon = polygons.front();
-  return Update();
+  bool success = Update();
+
+  // New geometry starts the view on the middle of the mesh.
+  if (!m_edgeLods.empty() && !m_edgeLods.front().edges.empty())
+    m_viewCentre = (m_edgeLods.front().minBounds + m_edgeLods.front().maxBounds) * 0.5f;
+  return success;
 }
 
 bool Triangulation::Update()
 {
   Clear();
+  m_arena.Reset();
+  std::pmr::memory_resource *pScratch = m_arena.Resource();
+
+  float stageTimes[StageCount] = {};
+  StageTimer timer;
 
   SetValueBounds();
+  stageTimes[StageValueBounds] = timer.Lap(StageValueBounds);
+
+  if (m_polygon.loops.empty())
+  {
+    RecordTimings(stageTimes);
+    return true;
+  }
+
+  // Keyed after SetValueBounds, which may clamp the size criteria.
+  Common::ContentHash hash;
+  hash.AddLoops(m_polygon.loops);
+  hash.Add(m_sizeCriteria);
+  hash.Add(m_shapeCriteria);
+  hash.Add(m_LloydIterations);
+  uint64_t key = hash.Value();
+
+  Common::CachedResult pResult = Common::ResultCache::Shared().Find(s_cacheCategory, key);
+  if (pResult != nullptr)
+  {
+    std::vector<vec2> meshVertices;
+    std::vector<MeshIndex::Triangle> meshTriangles;
+    std::vector<LodEdge> edges;
+    if (ReadResult(*pResult, &meshVertices, &meshTriangles, &edges))
+    {
+      m_meshIndex.Build(std::move(meshVertices), std::move(meshTriangles));
+      stageTimes[StageIndex] = timer.Lap(StageIndex);
+
+      BuildEdgeLods(edges, &m_edgeLods);
+      stageTimes[StageLods] = timer.Lap(StageLods);
+
+      m_fromCache = true;
+      RecordTimings(stageTimes);
+      return true;
+    }
+  }
 
   std::vector<Point> seeds = GenerateSeeds(m_polygon);
+  stageTimes[StageSeeds] = timer.Lap(StageSeeds);
 
   CDT cdt;
 
+  // Gather every loop point up front so they can be inserted in one batch.
+  std::pmr::vector<Point> points(pScratch);
+  std::pmr::vector<std::pair<size_t, size_t>> constraints(pScratch);
   for (auto const &poly : m_polygon.loops)
   {
-    std::vector<Vertex_handle> vertices;
+    size_t base = points.size();
+    size_t count = poly.Size();
     for (auto it = poly.cPointsBegin(); it != poly.cPointsEnd(); it++)
     {
       vec2 p = *it;
-      Point a(p.x(), p.y());
-      vertices.push_back(cdt.insert(a));
+      points.push_back(Point(p.x(), p.y()));
     }
 
-    for (size_t a = 0; a < vertices.size(); a++)
-    {
-      size_t b = (a + 1) % vertices.size();
-      cdt.insert(vertices[a], vertices[b]);
-    }
+    for (size_t a = 0; a < count; a++)
+      constraints.push_back(std::pair<size_t, size_t>(base + a, base + (a + 1) % count));
+  }
+
+  // Insert in Hilbert order, starting each point location from the face of the
+  // previously inserted vertex, so each walk is short.
+  std::pmr::vector<size_t> order(points.size(), pScratch);
+  std::iota(order.begin(), order.end(), 0);
+  CGAL::spatial_sort(order.begin(), order.end(), SortTraits(CGAL::make_property_map(points.data())));
+
+  std::pmr::vector<Vertex_handle> vertices(points.size(), pScratch);
+  Face_handle hint;
+  for (size_t i : order)
+  {
+    vertices[i] = cdt.insert(points[i], hint);
+    hint = vertices[i]->face();
   }
 
+  for (auto const &c : constraints)
+  {
+    if (vertices[c.first] != vertices[c.second])
+      cdt.insert_constraint(vertices[c.first], vertices[c.second]);
+  }
+  stageTimes[StageConstraints] = timer.Lap(StageConstraints);
+
   Mesher mesher(cdt);
   mesher.set_criteria(Criteria(m_shapeCriteria, m_sizeCriteria));
   mesher.set_seeds(seeds.begin(), seeds.end());
   mesher.refine_mesh();
+  stageTimes[StageRefine] = timer.Lap(StageRefine);
 
   if (m_LloydIterations > 0)
     CGAL::lloyd_optimize_mesh_2(cdt, CGAL::parameters::max_iteration_number = m_LloydIterations);
+  stageTimes[StageLloyd] = timer.Lap(StageLloyd);
+
+  BuildMeshIndex(cdt, &m_meshIndex);
+  stageTimes[StageIndex] = timer.Lap(StageIndex);
 
   m_vertCount = cdt.number_of_vertices();
   m_faceCount = cdt.number_of_faces();
@@ -214,6 +475,7 @@ bool Triangulation::Update()
     if (!it->is_in_domain())
       continue;
 
+    m_domainFaceCount++;
     for (int a = 0; a < 3; a++)
     {
       int b = (a + 1) % 3;
@@ -222,20 +484,93 @@ bool Triangulation::Update()
       m_edgeSet.insert(UniqueEdge(p0, p1));
     }
   }
+  stageTimes[StageFaces] = timer.Lap(StageFaces);
 
-  m_edges.clear();
+  std::vector<LodEdge> edges;
+  edges.reserve(m_edgeSet.size());
   for (auto it = m_edgeSet.cbegin_rand(); it != m_edgeSet.cend_rand(); it++)
   {
-    vec3 p0(it->p0.x(), it->p0.y(), 1.f);
-    vec3 p1(it->p1.x(), it->p1.y(), 1.f);
-    m_edges.push_back(seg(p0, p1));
+    LodEdge edge;
+    edge.p0 = it->p0;
+    edge.p1 = it->p1;
+    edges.push_back(edge);
   }
+  stageTimes[StageEdges] = timer.Lap(StageEdges);
 
+  BuildEdgeLods(edges, &m_edgeLods);
+  stageTimes[StageLods] = timer.Lap(StageLods);
+
+  WriteResult(key, edges);
+  RecordTimings(stageTimes);
   return true;
 }
 
+void Triangulation::WriteResult(uint64_t key, std::vector<LodEdge> const &edges)
+{
+  Common::ResultWriter writer;
+  writer.Write<uint64_t>(m_vertCount);
+  writer.Write<uint64_t>(m_faceCount);
+  writer.Write<uint64_t>(m_domainFaceCount);
+
+  writer.Write<uint64_t>(m_meshIndex.VertexCount());
+  for (size_t i = 0; i < m_meshIndex.VertexCount(); i++)
+    writer.WritePoint(m_meshIndex.GetVertex((uint32_t)i));
+
+  writer.Write<uint64_t>(m_meshIndex.TriangleCount());
+  for (size_t i = 0; i < m_meshIndex.TriangleCount(); i++)
+    writer.Write(m_meshIndex.GetTriangle((uint32_t)i));
+
+  writer.Write<uint64_t>(edges.size());
+  for (auto const &edge : edges)
+  {
+    writer.WritePoint(edge.p0);
+    writer.WritePoint(edge.p1);
+  }
+
+  Common::ResultCache::Shared().Insert(s_cacheCategory, key, std::move(writer.Data()));
+}
+
+bool Triangulation::ReadResult(std::vector<uint8_t> const &data, std::vector<vec2> *pVertices,
+                               std::vector<MeshIndex::Triangle> *pTriangles, std::vector<LodEdge> *pEdges)
+{
+  Common::ResultReader reader(data);
+  uint64_t counts[3] = {};
+  if (!reader.ReadBytes(counts, sizeof(counts)) || !reader.ReadPoints(pVertices) || !reader.ReadArray(pTriangles))
+    return false;
+
+  uint64_t edgeCount = 0;
+  if (!reader.Read(&edgeCount) || edgeCount > data.size() / (4 * sizeof(float)))
+    return false;
+
+  pEdges->resize((size_t)edgeCount);
+  for (auto &edge : *pEdges)
+  {
+    if (!reader.ReadPoint(&edge.p0) || !reader.ReadPoint(&edge.p1))
+      return false;
+  }
+
+  m_vertCount = (size_t)counts[0];
+  m_faceCount = (size_t)counts[1];
+  m_domainFaceCount = (size_t)counts[2];
+  return true;
+}
+
+void Triangulation::StartRecording()
+{
+  m_recorder.Start("Triangulation", m_simplifier.GetInput());
+  m_recorder.AddSetting("simplify", Common::FormatValue(m_simplifier.GetTolerance()));
+  m_recorder.AddSetting("size", Common::FormatValue(m_sizeCriteria));
+  m_recorder.AddSetting("shape", Common::FormatValue(m_shapeCriteria));
+  m_recorder.AddSetting("lloyd", Common::FormatValue(m_LloydIterations));
+}
+
 void Triangulation::_DoFrame(UIContext *pContext)
 {
+  XN_TRACE_MODULE_SCOPE(m_frameTimes, "Triangulation", "_DoFrame");
+  Common::ModulePanel panel{"Triangulation", &m_frameTimes, &m_simplifier, &m_arena, &m_recorder, s_cacheCategory,
+                            [this]() { StartRecording(); },
+                            [this]() { SetGeometry(m_simplifier.GetInput()); }};
+
   if (pContext->Button("What is this?##Triangulation"))
     pContext->OpenPopup("Description##Triangulation");
   if (pContext->BeginPopup("Description##Triangulation"))
@@ -246,20 +581,159 @@ void Triangulation::_DoFrame(UIContext *pContext)
     pContext->PopTextWrapPos();
     pContext->EndPopup();
   }
+  std::string error;
+  if (!Common::DoPanelHeader(pContext, panel, &error))
+    M_LOG_ERROR("%s", error.c_str());
+  pContext->Separator();
   pContext->Text("Vertices: %u", m_vertCount);
   pContext->Text("Faces: %u", m_faceCount);
+
+  float totalMs = 0.f;
+  for (int i = 0; i < StageCount; i++)
+  {
+    float lastMs = GetLastTiming(i);
+    totalMs += lastMs;
+    pContext->Text("%s: %.3f ms (avg %.3f ms)", s_stageNames[i], lastMs, AverageTiming(i));
+  }
+  // A result read from the cache was not triangulated, so it has no rate.
+  if (m_fromCache)
+    pContext->Text("Triangles/s: cache hit");
+  else
+    pContext->Text("Triangles/s: %.0f", totalMs > 0.f ? (float)m_domainFaceCount * 1000.f / totalMs : 0.f);
+  pContext->Text("Drawn edges: %u (LOD %u of %u)", (uint32_t)m_drawnEdges, (uint32_t)m_drawnLod, (uint32_t)m_edgeLods.size());
+  if (pContext->SliderFloat("Zoom (drag to move)##Triangulation", &m_viewZoom, 1.f, s_maxViewZoom))
+    SetView(m_viewCentre, m_viewZoom);
+  int maxDrawnK = (int)(m_maxDrawnEdges / 1000);
+  if (pContext->SliderInt("Max drawn edges (thousands)##Triangulation", &maxDrawnK, 0, 10000))
+    m_maxDrawnEdges = (size_t)maxDrawnK * 1000;
   pContext->Separator();
+  Common::DoSimplifyControls(pContext, panel);
   if (pContext->SliderFloat("Triangle size", &m_sizeCriteria, m_sizeCriteriaBounds.x(), m_sizeCriteriaBounds.y()))
+  {
+    m_recorder.ValueChanged("size", Common::FormatValue(m_sizeCriteria));
     Update();
+  }
 
   if (pContext->SliderFloat("Triangle shape", &m_shapeCriteria, 0.01f, 0.3f))
+  {
+    m_recorder.ValueChanged("shape", Common::FormatValue(m_shapeCriteria));
     Update();
+  }
 
   if (pContext->SliderInt("Lloyd iterations", &m_LloydIterations, 0, 50))
+  {
+    m_recorder.ValueChanged("lloyd", Common::FormatValue(m_LloydIterations));
     Update();
+  }
+}
+
+static bool IsVisible(EdgeTile const &tile, vec2 const &viewMin, vec2 const &viewMax)
+{
+  return tile.minBounds.x() <= viewMax.x() && tile.maxBounds.x() >= viewMin.x() &&
+         tile.minBounds.y() <= viewMax.y() && tile.maxBounds.y() >= viewMin.y();
+}
+
+static size_t CountVisibleEdges(EdgeLod const &lod, vec2 const &viewMin, vec2 const &viewMax)
+{
+  size_t count = 0;
+  for (auto const &tile : lod.tiles)
+  {
+    if (tile.count != 0 && IsVisible(tile, viewMin, viewMax))
+      count += tile.count;
+  }
+  return count;
+}
+
+void Triangulation::GetView(vec2 *pMin, vec2 *pMax, float *pPixelSize) const
+{
+  EdgeLod const &lod = m_edgeLods.front();
+  vec2 range = lod.maxBounds - lod.minBounds;
+  float extent = std::max(range.x(), range.y()) / m_viewZoom;
+  if (m_viewZoom <= 1.f)
+  {
+    *pMin = lod.minBounds;
+    *pMax = lod.maxBounds;
+  }
+  else
+  {
+    vec2 halfExtent(extent * 0.5f, extent * 0.5f);
+    *pMin = m_viewCentre - halfExtent;
+    *pMax = m_viewCentre + halfExtent;
+  }
+  *pPixelSize = extent / s_viewPixels;
+}
+
+// The coarsest level that still looks like the full mesh at this zoom, then
+// coarser levels while the visible edges are over the budget.
+size_t Triangulation::SelectLod(vec2 const &viewMin, vec2 const &viewMax, float pixelSize) const
+{
+  size_t lod = 0;
+  for (size_t i = 1; i < m_edgeLods.size(); i++)
+  {
+    if (m_edgeLods[i].clusterSize > pixelSize * s_lodPixelThreshold)
+      break;
+    lod = i;
+  }
+
+  while (m_maxDrawnEdges != 0 && lod + 1 < m_edgeLods.size() && CountVisibleEdges(m_edgeLods[lod], viewMin, viewMax) > m_maxDrawnEdges)
+    lod++;
+  return lod;
 }
 
 void Triangulation::Render(IRenderer *pRenderer)
 {
-  pRenderer->DrawLineGroup(m_edges.data(), (uint32_t)m_edges.size(), 1.f, xn::Colour(0xFFFF00FF), 0);
+  XN_TRACE_MODULE_SCOPE(m_frameTimes, "Triangulation", "Render");
+
+  m_drawnEdges = 0;
+  if (m_edgeLods.empty() || m_edgeLods.front().edges.empty())
+    return;
+
+  vec2 viewMin, viewMax;
+  float pixelSize = 0.f;
+  GetView(&viewMin, &viewMax, &pixelSize);
+  m_drawnLod = SelectLod(viewMin, viewMax, pixelSize);
+  EdgeLod const &lod = m_edgeLods[m_drawnLod];
+
+  // Even the coarsest level can be over the budget, so the run that crosses it is
+  // cut short and the tiles after it are dropped.
+  size_t budget = m_maxDrawnEdges == 0 ? lod.edges.size() : m_maxDrawnEdges;
+  uint32_t runBegin = 0;
+  uint32_t runCount = 0;
+  auto drawRun = [&]()
+  {
+    uint32_t count = (uint32_t)std::min((size_t)runCount, budget - m_drawnEdges);
+    pRenderer->DrawLineGroup(lod.edges.data() + runBegin, count, 1.f, xn::Colour(0xFFFF00FF), 0);
+    m_drawnEdges += count;
+    runCount = 0;
+  };
+
+  // Tiles are stored contiguously, so neighbouring visible tiles are merged into one
+  // call. The levels stay out of a Common::DrawStore: what is drawn is a different
+  // set of runs each frame, and a batch per tile would split every run into calls.
+  for (auto const &tile : lod.tiles)
+  {
+    if (m_drawnEdges + runCount >= budget)
+      break;
+    if (tile.count == 0)
+      continue;
+
+    bool visible = IsVisible(tile, viewMin, viewMax);
+    if (visible && runCount > 0 && tile.begin == runBegin + runCount)
+    {
+      runCount += tile.count;
+      continue;
+    }
+
+    if (runCount > 0)
+      drawRun();
+
+    if (visible)
+    {
+      runBegin = tile.begin;
+      runCount = tile.count;
+    }
+  }
+
+  if (runCount > 0)
+    drawRun();
 }
\ No newline at end of file
@@ -8,6 +8,14 @@
 #include "xnIRenderer.h"
 #include "DgSet_AVL.h"
 #include "xnModuleInitData.h"
+#include "MeshIndex.h"
+#include "EdgeLods.h"
+#include "Arena.h"
+#include "InputRecord.h"
+#include "ModulePanel.h"
+#include "ResultCache.h"
+#include "Simplify.h"
+#include "Trace.h"
 
 class Triangulation : public xn::Module
 {
@@ -17,13 +25,65 @@ public:
 
   void Clear();
 
+  void MouseDown(uint32_t modState, xn::vec2 const &) override;
+  void MouseUp(uint32_t modState) override;
+  void MouseMove(uint32_t modState, xn::vec2 const &) override;
   bool SetGeometry(std::vector<xn::PolygonLoop> const &) override;
   void Render(xn::IRenderer *) override;
 
+  // Point-location over the last generated mesh. See MeshIndex for threading rules.
+  MeshIndex const &GetMeshIndex() const { return m_meshIndex; }
+
+  // IRenderer does not expose the camera, so the module keeps its own view: the
+  // whole mesh at a zoom of 1, otherwise the mesh extent divided by the zoom,
+  // centred on the given point. Dragging the mouse moves the centre and the panel
+  // sets the zoom. Render draws only the tiles in the view, at the coarsest level
+  // whose cluster cells are still about a pixel across.
+  void SetView(xn::vec2 const &centre, float zoom);
+
+  // The most edges Render submits in a frame. Over it, Render moves to coarser
+  // levels, and past the coarsest drops the remaining visible tiles. 0 draws every
+  // visible edge.
+  void SetMaxDrawnEdges(size_t count) { m_maxDrawnEdges = count; }
+
+  // Parameters and results, for driving the module without the UI. The triangle
+  // size is clamped to a range derived from the geometry when the mesh is built.
+  void SetSizeCriteria(float size) { m_sizeCriteria = size; }
+  void SetShapeCriteria(float shape) { m_shapeCriteria = shape; }
+  void SetLloydIterations(int iterations) { m_LloydIterations = iterations; }
+  Common::Simplifier &GetSimplifier() { return m_simplifier; }
+  Common::Arena const &GetArena() const { return m_arena; }
+  bool Update();
+
+  size_t GetVertexCount() const { return m_vertCount; }
+  size_t GetFaceCount() const { return m_faceCount; }
+  size_t GetDomainFaceCount() const { return m_domainFaceCount; }
+  bool IsFromCache() const { return m_fromCache; }
+  size_t GetEdgeCount() const { return m_edgeLods.empty() ? 0 : m_edgeLods.front().edges.size(); }
+  size_t GetLodCount() const { return m_edgeLods.size(); }
+
+  // Timings of the last build, in milliseconds.
+  enum Stage
+  {
+    StageValueBounds,
+    StageSeeds,
+    StageConstraints,
+    StageRefine,
+    StageLloyd,
+    StageIndex,
+    StageFaces,
+    StageEdges,
+    StageLods,
+    StageCount
+  };
+
+  static char const *GetStageName(int stage);
+  float GetLastTiming(int stage) const;
+
 private:
 
   void _DoFrame(xn::UIContext *) override;
-  bool Update();
+  void StartRecording();
 
   class UniqueEdge
   {
@@ -39,12 +99,44 @@ private:
   };
 
   void SetValueBounds();
+  void GetView(xn::vec2 *pMin, xn::vec2 *pMax, float *pPixelSize) const;
+  size_t SelectLod(xn::vec2 const &viewMin, xn::vec2 const &viewMax, float pixelSize) const;
+
+  // The cached result is the mesh and its unique edges. The index and the edge
+  // levels of detail are rebuilt from them, which takes linear time.
+  void WriteResult(uint64_t key, std::vector<LodEdge> const &edges);
+  bool ReadResult(std::vector<uint8_t> const &data, std::vector<xn::vec2> *pVertices,
+                  std::vector<MeshIndex::Triangle> *pTriangles, std::vector<LodEdge> *pEdges);
 
+  // Rolling history of per-stage timings, in milliseconds.
+  static int const s_timingHistorySize = 32;
+
+  void RecordTimings(float const (&stageTimes)[StageCount]);
+  float AverageTiming(int stage) const;
+
+  Common::FrameTimes m_frameTimes;
+  Common::Simplifier m_simplifier;
+  Common::Arena m_arena;
+  Common::InputRecorder m_recorder;
   xn::PolygonWithHoles m_polygon;
   Dg::Set_AVL<UniqueEdge> m_edgeSet;
-  std::vector<xn::seg> m_edges;
+  std::vector<EdgeLod> m_edgeLods;
+  MeshIndex m_meshIndex;
+
+  xn::vec2 m_viewCentre;
+  float m_viewZoom;
+  bool m_mouseDown;
+  size_t m_maxDrawnEdges;
+  size_t m_drawnEdges;
+  size_t m_drawnLod;
   size_t m_vertCount;
   size_t m_faceCount;
+  size_t m_domainFaceCount;
+  bool m_fromCache;   // The last update read its result from the cache
+
+  float m_timings[StageCount][s_timingHistorySize];
+  int m_timingIndex;
+  int m_timingCount;
 
   xn::vec2 m_sizeCriteriaBounds;
   float m_sizeCriteria;
@@ -12,6 +12,8 @@ workspace "XornDemo"
   include("XornCore/premake-XornCore.lua")
   include("DgLib/premake-proj-DgLib.lua")
   include("XornApp/premake-XornApp.lua")
+  include("Common/premake-Common.lua")
+  include("Runner/premake-Runner.lua")
   group("Plugins")
 	include("premake-Samples.lua")
 	include("premake-XornPlugins.lua")